@@ -1,30 +1,609 @@
 // GalaxyQuadTree.cpp
 #include "GalaxyQuadTree.h"
+#include "LeafScan.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <utility>
 
 // Implement the constructor
-GalaxyQuadTree::GalaxyQuadTree(const sf::FloatRect &boundary, int capacity)
-    : root(nullptr), capacity(capacity)
+GalaxyQuadTree::GalaxyQuadTree(const sf::FloatRect &boundary, int capacity, int maxDepth, std::vector<Star> &starTable)
+    : SpatialIndex(starTable), capacity(capacity), maxDepth(std::min(maxDepth, MaxSupportedDepth)), boundary(boundary)
 {
-    // Initialize root and other necessary components
-    root = new GalaxyQuadTreeNode(boundary, capacity); // Initialize root with the provided boundary and capacity
+    // Start with an empty root; build() fills the tree in.
+    nodes.emplace_back(boundary, GalaxyQuadTreeNode::NoParent, 0, 0);
+    countAvailableStars();
 }
 
-// Implement the insert method
-void GalaxyQuadTree::insert(const Star &star)
+namespace
 {
-    // If the root node is not initialized, create it and assign the boundary and capacity
-    if (root == nullptr)
+    // Spreads the low 16 bits of value out to the even bits, for interleaving x and y into a Morton code.
+    uint32_t spreadBits(uint32_t value)
     {
-        root = new GalaxyQuadTreeNode(boundary, capacity);
+        value &= 0x0000FFFF;
+        value = (value | (value << 8)) & 0x00FF00FF;
+        value = (value | (value << 4)) & 0x0F0F0F0F;
+        value = (value | (value << 2)) & 0x33333333;
+        value = (value | (value << 1)) & 0x55555555;
+        return value;
+    }
+
+    // Position of each child in Z-order (NW, NE, SW, SE), given that children are numbered NE, NW, SW, SE.
+    const uint8_t ChildZOrder[4] = {1, 0, 2, 3};
+    const uint8_t ZOrderChild[4] = {1, 0, 2, 3};
+    const uint8_t OutsideChildren = 4; // falls in none of the children (float rounding at the far edges)
+}
+
+void GalaxyQuadTree::build(ThreadPool &threadPool)
+{
+    // Sort the stars by Morton (Z-order) code over the root boundary. Every node's stars are then one contiguous
+    // run of the sorted order, and the tree is cut out of it top-down without moving any star twice.
+    uint32_t starCount = static_cast<uint32_t>(starTable.size());
+    std::vector<uint32_t> codes(starCount);
+    const float cellsPerAxis = 65536.0f;
+    threadPool.parallelFor(starCount, [&](size_t begin, size_t end)
+                           {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const Star &star = starTable[i];
+            float cellX = std::floor((star.getX() - boundary.left) / boundary.width * cellsPerAxis);
+            float cellY = std::floor((star.getY() - boundary.top) / boundary.height * cellsPerAxis);
+            uint32_t x = static_cast<uint32_t>(std::min(std::max(cellX, 0.0f), cellsPerAxis - 1.0f));
+            uint32_t y = static_cast<uint32_t>(std::min(std::max(cellY, 0.0f), cellsPerAxis - 1.0f));
+            codes[i] = spreadBits(x) | (spreadBits(y) << 1);
+        } });
+
+    // LSD radix sort on the code, 16 bits per pass. It is stable, so stars with equal codes stay in table order.
+    std::vector<uint32_t> order(starCount);
+    std::vector<uint32_t> sortBuffer(starCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::vector<uint32_t> bucketStarts(1 << 16);
+    for (int shift = 0; shift < 32; shift += 16)
+    {
+        std::fill(bucketStarts.begin(), bucketStarts.end(), 0u);
+        for (uint32_t starIndex : order)
+        {
+            bucketStarts[(codes[starIndex] >> shift) & 0xFFFF]++;
+        }
+        uint32_t bucketStart = 0;
+        for (uint32_t &bucket : bucketStarts)
+        {
+            uint32_t bucketSize = bucket;
+            bucket = bucketStart;
+            bucketStart += bucketSize;
+        }
+        for (uint32_t starIndex : order)
+        {
+            sortBuffer[bucketStarts[(codes[starIndex] >> shift) & 0xFFFF]++] = starIndex;
+        }
+        order.swap(sortBuffer);
+    }
+
+    // Gather the coordinates in sorted order, so building the nodes reads memory front to back.
+    std::vector<sf::Vector2f> positions(starCount);
+    threadPool.parallelFor(starCount, [&](size_t begin, size_t end)
+                           {
+        for (size_t i = begin; i < end; ++i)
+        {
+            const Star &star = starTable[order[i]];
+            positions[i] = sf::Vector2f(star.getX(), star.getY());
+        } });
+
+    // Stars outside the root are kept in the table, at the end, but not indexed.
+    uint32_t insideCount = 0;
+    for (uint32_t i = 0; i < starCount; ++i)
+    {
+        if (boundary.contains(positions[i].x, positions[i].y))
+        {
+            order[insideCount] = order[i];
+            positions[insideCount] = positions[i];
+            insideCount++;
+        }
+        else
+        {
+            sortBuffer[i - insideCount] = order[i];
+        }
+    }
+    std::copy(sortBuffer.begin(), sortBuffer.begin() + (starCount - insideCount), order.begin() + insideCount);
+
+    // Cut the nodes out of the sorted order breadth-first. Each node is split into four consecutive children
+    // appended to the array, so the array ends up in breadth-first order: a node's children sit next to each
+    // other, and the top levels every search starts from share a few cache lines.
+    nodes.clear(); // keeps the storage, so a rebuild allocates nothing
+    nodes.emplace_back(boundary, GalaxyQuadTreeNode::NoParent, 0, insideCount);
+    std::vector<uint8_t> quadrants(starCount);
+    std::vector<sf::Vector2f> positionBuffer(starCount);
+    std::vector<int> nodeDepths(1, 0); // only needed while building
+    for (uint32_t nodeIndex = 0; nodeIndex < nodes.size(); ++nodeIndex)
+    {
+        // A node splits when it holds more than capacity stars, as if they had been inserted one by one.
+        const GalaxyQuadTreeNode &node = nodes[nodeIndex];
+        if (node.starCount <= static_cast<uint32_t>(capacity))
+        {
+            continue;
+        }
+
+        // Except that dense clusters stop at maxDepth, and stars on the same spot (coordinates are whole pixels,
+        // so zoomed-out catalogs have plenty) are never split at all, as no split can separate them. Both stay
+        // as overflow leaves holding more than capacity stars, which the searches scan like any other leaf.
+        if (nodeDepths[nodeIndex] >= maxDepth)
+        {
+            continue;
+        }
+        const sf::Vector2f *first = positions.data() + node.firstStar;
+        const sf::Vector2f *last = first + node.starCount;
+        if (std::all_of(first, last, [first](const sf::Vector2f &position)
+                        { return position == *first; }))
+        {
+            continue;
+        }
+
+        splitNode(nodeIndex, order, positions, sortBuffer, positionBuffer, quadrants);
+        nodeDepths.resize(nodes.size(), nodeDepths[nodeIndex] + 1);
+    }
+
+    // Lay the star table out in the sorted order, so neighbouring stars are neighbours in memory too. Node star
+    // lists were written as positions in that order, so they are already the new indices.
+    std::vector<Star> sortedStars;
+    sortedStars.reserve(starCount);
+    for (uint32_t starIndex : order)
+    {
+        sortedStars.push_back(std::move(starTable[starIndex]));
+    }
+    starTable.swap(sortedStars);
+    packStars();
+    countAvailableStars();
+}
+
+void GalaxyQuadTree::splitNode(uint32_t nodeIndex, std::vector<uint32_t> &order, std::vector<sf::Vector2f> &positions,
+                               std::vector<uint32_t> &orderBuffer, std::vector<sf::Vector2f> &positionBuffer, std::vector<uint8_t> &quadrants)
+{
+    const sf::FloatRect parentBoundary = nodes[nodeIndex].boundary;
+    const uint32_t begin = nodes[nodeIndex].firstStar;
+    const uint32_t end = begin + nodes[nodeIndex].starCount;
+
+    float subWidth = parentBoundary.width / 2.0f;
+    float subHeight = parentBoundary.height / 2.0f;
+    float x = parentBoundary.left;
+    float y = parentBoundary.top;
+    const sf::FloatRect childBoundaries[4] = {
+        sf::FloatRect(x + subWidth, y, subWidth, subHeight),
+        sf::FloatRect(x, y, subWidth, subHeight),
+        sf::FloatRect(x, y + subHeight, subWidth, subHeight),
+        sf::FloatRect(x + subWidth, y + subHeight, subWidth, subHeight)};
+
+    // Assign each star to the first child whose boundary contains it, and count per child.
+    uint32_t counts[5] = {0, 0, 0, 0, 0}; // in Z-order, then stars outside every child
+    bool alreadyGrouped = true;
+    uint8_t previousRank = 0;
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        uint8_t rank = OutsideChildren;
+        for (int child = 0; child < 4; ++child)
+        {
+            if (childBoundaries[child].contains(positions[i].x, positions[i].y))
+            {
+                rank = ChildZOrder[child];
+                break;
+            }
+        }
+        quadrants[i] = rank;
+        counts[rank]++;
+        alreadyGrouped = alreadyGrouped && rank >= previousRank;
+        previousRank = rank;
+    }
+
+    // Morton order already groups the stars by child, except where float rounding of the child boundaries
+    // disagrees with the code; regroup those runs with a stable counting sort.
+    if (!alreadyGrouped)
+    {
+        uint32_t offsets[5];
+        uint32_t offset = 0;
+        for (int rank = 0; rank < 5; ++rank)
+        {
+            offsets[rank] = offset;
+            offset += counts[rank];
+        }
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            uint32_t destination = offsets[quadrants[i]]++;
+            orderBuffer[destination] = order[i];
+            positionBuffer[destination] = positions[i];
+        }
+        std::copy(orderBuffer.begin(), orderBuffer.begin() + (end - begin), order.begin() + begin);
+        std::copy(positionBuffer.begin(), positionBuffer.begin() + (end - begin), positions.begin() + begin);
+    }
+
+    // Any stars left over, outside all four children, stay at the end of this node's run but in no leaf; searches scan
+    // them when they open this node.
+    uint32_t childStarts[4];
+    uint32_t childBegin = begin;
+    for (int rank = 0; rank < 4; ++rank)
+    {
+        childStarts[ZOrderChild[rank]] = childBegin;
+        childBegin += counts[rank];
+    }
+    uint32_t firstChild = static_cast<uint32_t>(nodes.size());
+    for (int child = 0; child < 4; ++child)
+    {
+        nodes.emplace_back(childBoundaries[child], nodeIndex, childStarts[child], counts[ChildZOrder[child]]);
+    }
+    nodes[nodeIndex].firstChild = firstChild;
+}
+
+void GalaxyQuadTree::assignNodes(const GalaxyQuadTreeNode *first, size_t count)
+{
+    nodes.assign(first, first + count);
+    packStars();
+    countAvailableStars();
+}
+
+void GalaxyQuadTree::packStars()
+{
+    uint32_t starCount = static_cast<uint32_t>(starTable.size());
+    starXs.resize(starCount);
+    starYs.resize(starCount);
+    availableMasks.resize(starCount);
+    for (uint32_t starIndex = 0; starIndex < starCount; ++starIndex)
+    {
+        const Star &star = starTable[starIndex];
+        starXs[starIndex] = static_cast<float>(star.getX());
+        starYs[starIndex] = static_cast<float>(star.getY());
+        availableMasks[starIndex] = star.getIsAvailable() ? AvailableMask : 0;
+    }
+}
+
+void GalaxyQuadTree::countAvailableStars()
+{
+    // Children come after their parent, so walking the array backwards sees every child before its parent. A
+    // node's children cover the front of its range; anything after them is outside all four and counted directly.
+    availableStarCounts = std::vector<std::atomic<uint32_t>>(nodes.size());
+    for (size_t nodeIndex = nodes.size(); nodeIndex-- > 0;)
+    {
+        const GalaxyQuadTreeNode &node = nodes[nodeIndex];
+        uint32_t available = 0;
+        uint32_t uncountedStar = node.firstStar;
+        if (!node.isLeaf())
+        {
+            for (int i = 0; i < 4; ++i)
+            {
+                uint32_t childIndex = node.getChild(i);
+                available += availableStarCounts[childIndex].load(std::memory_order_relaxed);
+                uncountedStar += nodes[childIndex].starCount;
+            }
+        }
+        for (uint32_t starIndex = uncountedStar; starIndex < node.firstStar + node.starCount; ++starIndex)
+        {
+            available += starTable[starIndex].getIsAvailable() ? 1 : 0;
+        }
+        availableStarCounts[nodeIndex].store(available, std::memory_order_relaxed);
     }
-    // Insert the star into the root node or recursively call an insertion method on the root node
-    root->insert(star);
+}
+
+void GalaxyQuadTree::availableStarCountChanged(uint32_t starIndex, int delta)
+{
+    availableMasks[starIndex] = delta > 0 ? AvailableMask : 0;
+
+    // Every subtree is one run of the star table, so the star's path from the root is found from the ranges alone.
+    uint32_t nodeIndex = 0;
+    while (nodeIndex != GalaxyQuadTreeNode::NoChildren)
+    {
+        const GalaxyQuadTreeNode &node = nodes[nodeIndex];
+        if (starIndex < node.firstStar || starIndex >= node.firstStar + node.starCount)
+        {
+            break; // not indexed below here
+        }
+        availableStarCounts[nodeIndex].fetch_add(static_cast<uint32_t>(delta), std::memory_order_relaxed);
+
+        uint32_t nextNode = GalaxyQuadTreeNode::NoChildren;
+        for (int i = 0; i < 4 && !node.isLeaf(); ++i)
+        {
+            const GalaxyQuadTreeNode &child = nodes[node.getChild(i)];
+            if (starIndex >= child.firstStar && starIndex < child.firstStar + child.starCount)
+            {
+                nextNode = node.getChild(i);
+                break;
+            }
+        }
+        nodeIndex = nextNode;
+    }
+}
+
+uint32_t GalaxyQuadTree::getAvailableStarCount(uint32_t nodeIndex) const
+{
+    return availableStarCounts[nodeIndex].load(std::memory_order_relaxed);
+}
+
+const GalaxyQuadTreeNode &GalaxyQuadTree::getRootNode() const
+{
+    return nodes.front();
+}
+
+const GalaxyQuadTreeNode &GalaxyQuadTree::getNode(uint32_t nodeIndex) const
+{
+    return nodes[nodeIndex];
+}
+
+const std::vector<GalaxyQuadTreeNode> &GalaxyQuadTree::getNodes() const
+{
+    return nodes;
 }
 
 void GalaxyQuadTree::debugPrint() const
 {
-    if (root)
+    debugPrintNode(0, 0);
+}
+
+void GalaxyQuadTree::debugPrintNode(uint32_t nodeIndex, int depth) const
+{
+    const GalaxyQuadTreeNode &node = nodes[nodeIndex];
+    std::string indent(depth * 2, ' '); // Create an indent based on the depth
+
+    std::cout << indent << "Node Boundary: " << node.boundary.left << ", " << node.boundary.top << ", "
+              << node.boundary.width << ", " << node.boundary.height << std::endl;
+
+    if (node.isLeaf())
+    {
+        for (uint32_t starIndex = node.firstStar; starIndex < node.firstStar + node.starCount; ++starIndex)
+        {
+            const Star &star = starTable[starIndex];
+            std::cout << indent << "  Star: ";
+
+            if (!star.getName().empty())
+            {
+                std::cout << star.getName();
+            }
+            else
+            {
+                std::cout << "Unnamed";
+            }
+
+            std::cout << " (" << star.getX() << ", " << star.getY() << ")" << std::endl;
+        }
+    }
+    else
     {
-        root->debugPrint();
+        for (int i = 0; i < 4; ++i)
+        {
+            debugPrintNode(node.getChild(i), depth + 1);
+        }
     }
-}
\ No newline at end of file
+}
+
+namespace
+{
+    // One entry of the best-first search queue: either a node still to be opened, or a star that passed the filter.
+    struct NearestSearchEntry
+    {
+        float distanceSquared;
+        uint32_t nodeIndex; // GalaxyQuadTreeNode::NoChildren for star entries
+        uint32_t starIndex;
+    };
+
+    // Min-heap ordering on distance. Ties go to stars before nodes, then to the lower star index, so results never depend on heap internals.
+    struct NearestSearchEntryGreater
+    {
+        bool operator()(const NearestSearchEntry &a, const NearestSearchEntry &b) const
+        {
+            if (a.distanceSquared != b.distanceSquared)
+            {
+                return a.distanceSquared > b.distanceSquared;
+            }
+            bool aIsStar = a.nodeIndex == GalaxyQuadTreeNode::NoChildren;
+            bool bIsStar = b.nodeIndex == GalaxyQuadTreeNode::NoChildren;
+            if (aIsStar != bIsStar)
+            {
+                return !aIsStar;
+            }
+            return a.starIndex > b.starIndex;
+        }
+    };
+
+    // Squared distance from a point inside rect to its nearest edge, so every point outside rect is at least this far away.
+    float distanceSquaredToEdge(const sf::Vector2f &point, const sf::FloatRect &rect)
+    {
+        if (!rect.contains(point))
+        {
+            return 0.0f;
+        }
+        float dx = std::min(point.x - rect.left, rect.left + rect.width - point.x);
+        float dy = std::min(point.y - rect.top, rect.top + rect.height - point.y);
+        float edgeDistance = std::min(dx, dy);
+        return edgeDistance * edgeDistance;
+    }
+}
+
+uint32_t GalaxyQuadTree::locate(const sf::Vector2f &point, uint32_t hint) const
+{
+    return findLeaf(point, hint);
+}
+
+uint32_t GalaxyQuadTree::findLeaf(const sf::Vector2f &point, uint32_t startNode) const
+{
+    // Climb from startNode until its boundary holds the point, then go down. A probe that moved to a nearby star
+    // usually only climbs a level or two.
+    uint32_t nodeIndex = startNode < nodes.size() ? startNode : 0;
+    while (nodes[nodeIndex].parent != GalaxyQuadTreeNode::NoParent && !nodes[nodeIndex].boundary.contains(point))
+    {
+        nodeIndex = nodes[nodeIndex].parent;
+    }
+    while (!nodes[nodeIndex].isLeaf())
+    {
+        uint32_t childIndex = GalaxyQuadTreeNode::NoChildren;
+        for (int i = 0; i < 4; ++i)
+        {
+            if (nodes[nodes[nodeIndex].getChild(i)].boundary.contains(point))
+            {
+                childIndex = nodes[nodeIndex].getChild(i);
+                break;
+            }
+        }
+        if (childIndex == GalaxyQuadTreeNode::NoChildren)
+        {
+            break; // in this node but none of its children (float rounding at the far edges)
+        }
+        nodeIndex = childIndex;
+    }
+    return nodeIndex;
+}
+
+void GalaxyQuadTree::findInRadius(const sf::Vector2f &center, float radius, std::vector<uint32_t> &results) const
+{
+    results.clear();
+    forEachStarInRadius(center, radius, [&results](uint32_t starIndex)
+                        { results.push_back(starIndex); });
+}
+
+void GalaxyQuadTree::findInRect(const sf::FloatRect &rect, std::vector<uint32_t> &results) const
+{
+    results.clear();
+    forEachStarInRect(rect, [&results](uint32_t starIndex)
+                      { results.push_back(starIndex); });
+}
+
+void GalaxyQuadTree::searchNearest(const sf::Vector2f &point, size_t k, const StarFilter &filter, std::vector<uint32_t> &results, float maxDistance, uint32_t startNode, bool availableOnly) const
+{
+    results.clear();
+    if (k == 0)
+    {
+        return;
+    }
+
+    // The queue storage is reused between calls on the same thread, so a steady-state search does not allocate.
+    static thread_local std::vector<NearestSearchEntry> queue;
+    queue.clear();
+    NearestSearchEntryGreater greater;
+    float maxDistanceSquared = maxDistance * maxDistance;
+    float nearestQueuedDistanceSquared = std::numeric_limits<float>::infinity(); // only kept for k == 1
+
+    // With availableOnly, a node whose stars are all claimed or explored can hold no result, so it is never opened.
+    // Late in a run that cuts the search down to the part of the map still unexplored.
+    if (availableOnly && getAvailableStarCount(0) == 0)
+    {
+        return;
+    }
+
+    // Scan a run of the star table a block at a time with the packed coordinates. For a single nearest star, only
+    // the closest star of each block that passes can be the answer, and nothing further than a star already queued
+    // can, so just that one is queued and the bound shrinks as the search goes on.
+    auto scanStars = [&](uint32_t firstStar, uint32_t endStar)
+    {
+        for (uint32_t blockStart = firstStar; blockStart < endStar; blockStart += LeafScan::BlockSize)
+        {
+            uint32_t blockCount = std::min(LeafScan::BlockSize, endStar - blockStart);
+            float bound = k == 1 ? std::min(maxDistanceSquared, nearestQueuedDistanceSquared) : maxDistanceSquared;
+            float distancesSquared[LeafScan::BlockSize];
+            uint64_t candidates = LeafScan::scanBlock(starXs.data() + blockStart, starYs.data() + blockStart,
+                                                      availableOnly ? availableMasks.data() + blockStart : nullptr, blockCount, point, bound, distancesSquared);
+            uint32_t blockNearest = InvalidIndex;
+            for (uint32_t lane = 0; candidates != 0; ++lane, candidates >>= 1)
+            {
+                uint32_t starIndex = blockStart + lane;
+                float distanceSquared = distancesSquared[lane];
+                if ((candidates & 1) == 0 || (blockNearest != InvalidIndex && distanceSquared >= nearestQueuedDistanceSquared) || !filter(starIndex))
+                {
+                    continue;
+                }
+                if (k == 1)
+                {
+                    blockNearest = starIndex; // ties go to the lower index, which comes first
+                    nearestQueuedDistanceSquared = distanceSquared;
+                    continue;
+                }
+                queue.push_back({distanceSquared, GalaxyQuadTreeNode::NoChildren, starIndex});
+                std::push_heap(queue.begin(), queue.end(), greater);
+            }
+            if (blockNearest != InvalidIndex)
+            {
+                queue.push_back({nearestQueuedDistanceSquared, GalaxyQuadTreeNode::NoChildren, blockNearest});
+                std::push_heap(queue.begin(), queue.end(), greater);
+            }
+        }
+    };
+
+    // A split node's run ends with any stars float rounding left out of all four children. They are in no leaf,
+    // so they are scanned whenever their node is opened, or becomes the scope.
+    auto scanLeftOverStars = [&](const GalaxyQuadTreeNode &node)
+    {
+        const GalaxyQuadTreeNode &lastChild = nodes[node.getChild(3)]; // SE comes last in Z-order
+        scanStars(lastChild.firstStar + lastChild.starCount, node.firstStar + node.starCount);
+    };
+
+    // Search the scope node first. Everything outside it is at least exitDistanceSquared away, so while the next
+    // entry is closer than that the answer cannot be outside. Otherwise widen the scope to the parent and queue
+    // the parent's other children, the scope's neighbours. The root's scope has no outside.
+    uint32_t scope = findLeaf(point, startNode);
+    float exitDistanceSquared = scope == 0 ? std::numeric_limits<float>::infinity() : distanceSquaredToEdge(point, nodes[scope].boundary);
+    if (!availableOnly || getAvailableStarCount(scope) > 0)
+    {
+        queue.push_back({distanceSquaredToRect(point, nodes[scope].boundary), scope, InvalidIndex});
+    }
+    while (true)
+    {
+        bool mayBeOutside = queue.empty() || queue.front().distanceSquared >= exitDistanceSquared;
+        if (scope != 0 && mayBeOutside && exitDistanceSquared <= maxDistanceSquared)
+        {
+            uint32_t previousScope = scope;
+            scope = nodes[scope].parent;
+            scanLeftOverStars(nodes[scope]);
+            for (int i = 0; i < 4; ++i)
+            {
+                uint32_t childIndex = nodes[scope].getChild(i);
+                if (childIndex == previousScope || (availableOnly && getAvailableStarCount(childIndex) == 0))
+                {
+                    continue;
+                }
+                queue.push_back({distanceSquaredToRect(point, nodes[childIndex].boundary), childIndex, InvalidIndex});
+                std::push_heap(queue.begin(), queue.end(), greater);
+            }
+            exitDistanceSquared = scope == 0 ? std::numeric_limits<float>::infinity() : distanceSquaredToEdge(point, nodes[scope].boundary);
+            continue;
+        }
+        if (queue.empty())
+        {
+            break;
+        }
+
+        std::pop_heap(queue.begin(), queue.end(), greater);
+        NearestSearchEntry entry = queue.back();
+        queue.pop_back();
+
+        if (entry.distanceSquared > maxDistanceSquared)
+        {
+            break; // everything left in the queue is at least this far away
+        }
+
+        if (entry.nodeIndex == GalaxyQuadTreeNode::NoChildren)
+        {
+            // A star surfaces only once nothing left in the queue can be closer, so it is the next nearest.
+            results.push_back(entry.starIndex);
+            if (results.size() == k)
+            {
+                break;
+            }
+            continue;
+        }
+
+        const GalaxyQuadTreeNode &node = nodes[entry.nodeIndex];
+        if (node.isLeaf())
+        {
+            scanStars(node.firstStar, node.firstStar + node.starCount);
+        }
+        else
+        {
+            scanLeftOverStars(node);
+            for (int i = 0; i < 4; ++i)
+            {
+                uint32_t childIndex = node.getChild(i);
+                if (availableOnly && getAvailableStarCount(childIndex) == 0)
+                {
+                    continue;
+                }
+                queue.push_back({distanceSquaredToRect(point, nodes[childIndex].boundary), childIndex, InvalidIndex});
+                std::push_heap(queue.begin(), queue.end(), greater);
+            }
+        }
+    }
+}
@@ -3,21 +3,175 @@
 
 #include <SFML/Graphics.hpp>	// Include necessary headers
 #include "GalaxyQuadTreeNode.h" // Include the node structure
+#include "SpatialIndex.h"
+#include "Star.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
 
-class GalaxyQuadTree
+// The default spatial index ("quadtree"). Each node is a run of the Z-ordered star table, split into four
+// quadrants once it holds more than capacity stars. Nodes track how many available stars they hold, so searches
+// skip explored regions, and a search starts in the leaf named by the hint (see findLeaf).
+class GalaxyQuadTree : public SpatialIndex
 {
 public:
-	GalaxyQuadTree(const sf::FloatRect &boundary, int capacity); // Constructor
-	void insert(const Star &star);								 // Insert a star into the quadtree
-	std::vector<Star> query(const sf::Vector2f &point, float radius);
-	GalaxyQuadTreeNode *getRootNode() const
-	{
-		return root;
-	} // Query stars within a radius around a point
+	static constexpr int MaxSupportedDepth = 32; // deeper maxDepth values are clamped, so range queries need only a fixed stack
+
+	GalaxyQuadTree(const sf::FloatRect &boundary, int capacity, int maxDepth, std::vector<Star> &starTable); // Constructor, the tree indexes into starTable
+	// Build the tree over the whole star table. Reorders the table into Z-order, so indices change. Nodes at maxDepth,
+	// or whose stars all share one position, are left as leaves holding more than capacity stars.
+	void build(ThreadPool &threadPool) override;
+	void assignNodes(const GalaxyQuadTreeNode *first, size_t count); // Replace the tree with nodes saved from a tree built over the same star table
+
+	uint32_t locate(const sf::Vector2f &point, uint32_t hint = 0) const override; // findLeaf
+	uint32_t findLeaf(const sf::Vector2f &point, uint32_t startNode = 0) const;	 // deepest node holding point, or the root if point is off the map
+	void findInRadius(const sf::Vector2f &center, float radius, std::vector<uint32_t> &results) const override;
+	void findInRect(const sf::FloatRect &rect, std::vector<uint32_t> &results) const override;
+	// Call visit(starIndex) for every star within radius of center, or inside rect, in no particular order. They
+	// walk the tree with a fixed stack and allocate nothing, so they are safe in per-frame and per-probe loops.
+	template <typename Visitor>
+	void forEachStarInRadius(const sf::Vector2f &center, float radius, Visitor &&visit) const;
+	template <typename Visitor>
+	void forEachStarInRect(const sf::FloatRect &rect, Visitor &&visit) const;
+	uint32_t getAvailableStarCount(uint32_t nodeIndex) const;
+	const GalaxyQuadTreeNode &getRootNode() const;
+	const GalaxyQuadTreeNode &getNode(uint32_t nodeIndex) const;
+	const std::vector<GalaxyQuadTreeNode> &getNodes() const; // breadth-first, root first
 	void debugPrint() const;
 
+protected:
+	// Best-first nearest neighbour search. Nodes and stars are visited in order of squared distance from point
+	// using a priority queue, so only the nodes that could hold a closer star are ever opened. The search starts in
+	// the leaf holding point, found by walking from startNode (a node the caller was recently in, such as a probe's
+	// last leaf), and widens towards the root only while a closer star could lie outside.
+	void searchNearest(const sf::Vector2f &point, size_t k, const StarFilter &filter, std::vector<uint32_t> &results, float maxDistance, uint32_t startNode, bool availableOnly) const override;
+	void availableStarCountChanged(uint32_t starIndex, int delta) override; // applied to the star's mask and every node whose range holds it
+
 private:
-	GalaxyQuadTreeNode *root; // Pointer to the root node of the quadtree
+	void splitNode(uint32_t nodeIndex, std::vector<uint32_t> &order, std::vector<sf::Vector2f> &positions,
+				   std::vector<uint32_t> &orderBuffer, std::vector<sf::Vector2f> &positionBuffer, std::vector<uint8_t> &quadrants);
+	void debugPrintNode(uint32_t nodeIndex, int depth) const;
+	void packStars();			// copy coordinates and availability out of the star table, after it or the nodes change
+	void countAvailableStars(); // recount every node from the star states, after the nodes are replaced
+	// Shared walk for the range queries. nodeOverlap(boundary) says whether a node lies outside the range (None),
+	// inside it entirely (All, so its stars are visited untested) or across its edge (Some, so they are tested).
+	enum class Overlap
+	{
+		None,
+		Some,
+		All
+	};
+	template <typename NodeOverlap, typename StarInRange, typename Visitor>
+	void forEachStarInRange(NodeOverlap &&nodeOverlap, StarInRange &&starInRange, Visitor &&visit) const;
+
+	std::vector<GalaxyQuadTreeNode> nodes; // every node of the tree, nodes[0] is the root
+	std::vector<std::atomic<uint32_t>> availableStarCounts; // per node, available stars in its star range; kept apart so nodes stay plain data
+
+	// The star table's coordinates and availability packed per star, in table order, for the leaf scans. Masks are
+	// AvailableMask or 0 and change only with claims, releases and explorations, which the simulation makes between
+	// its parallel search phases.
+	static constexpr uint32_t AvailableMask = 0xFFFFFFFF;
+	std::vector<float> starXs;
+	std::vector<float> starYs;
+	std::vector<uint32_t> availableMasks;
 	int capacity;			  // Maximum capacity of stars in a node before splitting
+	int maxDepth;			  // Nodes this deep (the root is 0) are never split, however many stars they hold
 	sf::FloatRect boundary;	  // Other private helper methods for insertion, splitting nodes, querying, etc.
-};
\ No newline at end of file
+};
+
+template <typename NodeOverlap, typename StarInRange, typename Visitor>
+void GalaxyQuadTree::forEachStarInRange(NodeOverlap &&nodeOverlap, StarInRange &&starInRange, Visitor &&visit) const
+{
+	// Depth first, so the stack holds at most three waiting siblings per level plus the four children last pushed.
+	uint32_t stack[3 * MaxSupportedDepth + 4];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const GalaxyQuadTreeNode &node = nodes[stack[--stackSize]];
+		Overlap overlap = nodeOverlap(node.boundary);
+		if (overlap == Overlap::None)
+		{
+			continue;
+		}
+
+		// Every star in a node's run lies inside its boundary, including the rare ones float rounding left out of
+		// all four children, which sit after the children's runs.
+		uint32_t firstStar = node.firstStar;
+		if (!node.isLeaf())
+		{
+			const GalaxyQuadTreeNode &lastChild = nodes[node.getChild(3)]; // SE comes last in Z-order
+			firstStar = lastChild.firstStar + lastChild.starCount;
+			if (overlap == Overlap::All)
+			{
+				firstStar = node.firstStar;
+			}
+			else
+			{
+				for (int i = 0; i < 4; ++i)
+				{
+					stack[stackSize++] = node.getChild(i);
+				}
+			}
+		}
+		for (uint32_t starIndex = firstStar; starIndex < node.firstStar + node.starCount; ++starIndex)
+		{
+			if (overlap == Overlap::All || starInRange(starTable[starIndex]))
+			{
+				visit(starIndex);
+			}
+		}
+	}
+}
+
+template <typename Visitor>
+void GalaxyQuadTree::forEachStarInRadius(const sf::Vector2f &center, float radius, Visitor &&visit) const
+{
+	float radiusSquared = radius * radius;
+	forEachStarInRange(
+		[&center, radiusSquared](const sf::FloatRect &boundary)
+		{
+			if (distanceSquaredToRect(center, boundary) > radiusSquared)
+			{
+				return Overlap::None;
+			}
+			float dx = std::max(center.x - boundary.left, boundary.left + boundary.width - center.x);
+			float dy = std::max(center.y - boundary.top, boundary.top + boundary.height - center.y);
+			return dx * dx + dy * dy <= radiusSquared ? Overlap::All : Overlap::Some; // furthest corner inside too
+		},
+		[&center, radiusSquared](const Star &star)
+		{
+			float dx = star.getX() - center.x;
+			float dy = star.getY() - center.y;
+			return dx * dx + dy * dy <= radiusSquared;
+		},
+		visit);
+}
+
+template <typename Visitor>
+void GalaxyQuadTree::forEachStarInRect(const sf::FloatRect &rect, Visitor &&visit) const
+{
+	// Same edges as sf::FloatRect::contains, which allows negative sizes and excludes the right and bottom edges.
+	float left = std::min(rect.left, rect.left + rect.width);
+	float right = std::max(rect.left, rect.left + rect.width);
+	float top = std::min(rect.top, rect.top + rect.height);
+	float bottom = std::max(rect.top, rect.top + rect.height);
+	forEachStarInRange(
+		[left, right, top, bottom](const sf::FloatRect &boundary)
+		{
+			if (right <= boundary.left || boundary.left + boundary.width <= left || bottom <= boundary.top || boundary.top + boundary.height <= top)
+			{
+				return Overlap::None;
+			}
+			bool inside = left <= boundary.left && boundary.left + boundary.width <= right &&
+						  top <= boundary.top && boundary.top + boundary.height <= bottom;
+			return inside ? Overlap::All : Overlap::Some;
+		},
+		[&rect](const Star &star)
+		{
+			return rect.contains(star.getX(), star.getY());
+		},
+		visit);
+}
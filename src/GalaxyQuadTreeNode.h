@@ -2,20 +2,23 @@
 #pragma once
 
 #include <SFML/Graphics.hpp>
-#include "Star.h"
-#include <vector>
+#include <cstdint>
+#include <limits>
 
+// One node of a GalaxyQuadTree. Nodes live in a single array owned by the tree and refer to each other by index.
+// They own no memory, so the whole tree is freed, reset or copied in one go.
 struct GalaxyQuadTreeNode
 {
+	static constexpr uint32_t NoChildren = std::numeric_limits<uint32_t>::max();
+	static constexpr uint32_t NoParent = std::numeric_limits<uint32_t>::max();
+
 	sf::FloatRect boundary;
-	std::vector<Star> stars;
-	GalaxyQuadTreeNode *children[4];
-	bool isLeaf;
-	int capacity;
+	uint32_t parent;	 // node index of the parent, NoParent for the root
+	uint32_t firstChild; // node index of the first of four consecutive children (NE, NW, SW, SE), NoChildren for a leaf
+	uint32_t firstStar;	 // the node's stars are star table entries [firstStar, firstStar + starCount), as the tree
+	uint32_t starCount;	 // keeps the table sorted so every subtree is one run
 
-	GalaxyQuadTreeNode(const sf::FloatRect &nodeBoundary, int nodeCapacity);
-	GalaxyQuadTreeNode *getChild(int index) const;
-	bool insert(const Star &star);
-	void split();
-	void debugPrint(int depth = 0) const;
-};
\ No newline at end of file
+	GalaxyQuadTreeNode(const sf::FloatRect &nodeBoundary, uint32_t parent, uint32_t firstStar, uint32_t starCount);
+	bool isLeaf() const;
+	uint32_t getChild(int index) const; // node index of child 0-3, or NoChildren
+};
@@ -4,71 +4,26 @@
 #include "LoadCSVData.h"
 #include "Probe.h"
 #include "RenderSystem.h"
-#include "Utilities.h"
-#include "GalaxyQuadTree.h"
+#include "Simulation.h"
 #include <SFML/System/Clock.hpp>
 #include <SFML/System/Time.hpp>
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 
 Game::Game(const LoadConfig &config) :
 
 									   window(sf::VideoMode(config.getWindowWidth(), config.getWindowHeight()), "Star Map"),
-									   renderSystem(window),
+									   renderSystem(window, config),
 									   config(config),
-									   theQuadTreeInstance(sf::FloatRect(0.f, 0.f, config.getWindowWidth(), config.getWindowHeight()), config.getQuadTreeSearchSize())
+									   simulation(config),
+									   dragging(false)
 {
-	// Load star systems from CSV file into GalaxyVector
-	LoadCSVData dataLoader2;
-	galaxyVector = dataLoader2.loadStarsFromCsv("./content/hygdata_v40.csv", window, config);
-	if (!galaxyVector.empty())
-	{
-		std::cout << "galaxyVector2 vector is populated with " << galaxyVector.size() << " stars." << std::endl;
-	}
-	else
-	{
-		std::cout << "galaxyVector vector is empty." << std::endl;
-	}
-
-	sf::Vector2u windowSize = window.getSize();
-
-	// Calculate the center coordinates
-	int centerX = windowSize.x / 2;
-	int centerY = windowSize.y / 2;
-
-	// build a texture of all the stars which can be reused each frame
-	// renderSystem.initializeStarsTexture(galaxyVector); //comment out while implementing galaxyVector2 (new csv)
-	renderSystem.initializeStarsTexture(galaxyVector);
-
-	// Create a mapping table of star names to their ID values. Used for passing to probe namer.
-	Utilities::populateStarData(galaxyVector);
-
-	// Assume gameBounds represent the entire playable area, and pull quadtree depth from config;
-	sf::FloatRect gameBounds(0.f, 0.f, config.getWindowWidth(), config.getWindowHeight());
-	int QuadTreeCapacity = config.getQuadTreeSearchSize();
-
-	// Example population of the quadtree in Game.cpp
-	for (const auto &star : galaxyVector)
-	{
-		theQuadTreeInstance.insert(star); // Use 'quadTree' instance to call the insert method
-	}
-#if defined(_DEBUG)
-	// theQuadTreeInstance.debugPrint(); // This will print the structure of the quadtree and the stars in each node EXTREME VERBOSE!
-#endif
-	// create a mapping of starID values to star names.
-
-	// Instantiate a probe class called firstProbe - galaxyVector as argument so data is shared between probe instances.
-	// Probe firstProbe("SOL-SOL-AAA", centerX, centerY, 0.0f, galaxyVector, theQuadTreeInstance); // Example coordinates and speed
-	Probe firstProbe("SOL-SOL-AAA", centerX, centerY, 0.0f, theQuadTreeInstance); // Example coordinates and speed
-	firstProbe.setMode(ProbeMode::Seek);
-	firstProbe.setNewBorn(false);
-	firstProbe.setRandomTrailColor();
-	sf::Vector2f SolCoordinates(centerX, centerY); // Replace these values with actual coordinates
-	firstProbe.addVisitedStarSystem(0, SolCoordinates, true);
-	firstProbe.setSpeed(1); // make sure starter system is set
-	firstProbe.move();		// currently running the actual logic of the probe from its class.
-	// and add it to the probeVector (a list of all probes in simulation)
-	probeVector.push_back(firstProbe);
+	// stars are drawn from tiles rasterised as the camera first needs them, and reused from then on
+	renderSystem.initializeStarTiles(simulation.getSpatialIndex(), simulation.getQuadTree(), simulation.getMapBoundary());
+	renderSystem.initializeStarLabels(simulation.getGalaxyVector());
+	resetCamera();
 }
 
 void Game::initializeKeyBindings()
@@ -76,13 +31,23 @@ void Game::initializeKeyBindings()
 	keyBindings[sf::Keyboard::Escape] = [this]()
 	{ window.close(); };
 	keyBindings[sf::Keyboard::F1] = [this]()
-	{ renderSystem.toggleTextLabelsStars(); renderSystem.initializeStarsTexture(galaxyVector); };
+	{ renderSystem.toggleTextLabelsStars(); };
 	keyBindings[sf::Keyboard::F2] = [this]()
-	{ renderSystem.toggleTextLabelsProbes(); renderSystem.initializeStarsTexture(galaxyVector); };
+	{ renderSystem.toggleTextLabelsProbes(); };
 	keyBindings[sf::Keyboard::F3] = [this]()
 	{ renderSystem.toggleProbeTrails(); };
 	keyBindings[sf::Keyboard::F12] = [this]()
 	{ renderSystem.toggleDebugGraphics(); };
+	keyBindings[sf::Keyboard::Left] = [this]()
+	{ panCamera(sf::Vector2f(-camera.getSize().x / 4, 0.0f)); };
+	keyBindings[sf::Keyboard::Right] = [this]()
+	{ panCamera(sf::Vector2f(camera.getSize().x / 4, 0.0f)); };
+	keyBindings[sf::Keyboard::Up] = [this]()
+	{ panCamera(sf::Vector2f(0.0f, -camera.getSize().y / 4)); };
+	keyBindings[sf::Keyboard::Down] = [this]()
+	{ panCamera(sf::Vector2f(0.0f, camera.getSize().y / 4)); };
+	keyBindings[sf::Keyboard::Home] = [this]()
+	{ resetCamera(); };
 }
 
 void Game::run()
@@ -101,7 +66,7 @@ void Game::run()
 		sf::Time elapsed = clock.restart();
 
 		handleEvents();
-		updateGameState();
+		simulation.updateGameState();
 		render();
 
 		++iteration;
@@ -120,9 +85,9 @@ void Game::run()
 	std::chrono::duration<double> simulationDuration = simulationEndTime - simulationStartTime;
 
 	double simulationTimeInSeconds = simulationDuration.count();
-	this->simulationTimeInSeconds = simulationTimeInSeconds; // Assign value
+	simulation.setSimulationTimeInSeconds(simulationTimeInSeconds); // Assign value
 	std::cout << "Simulation took " << simulationTimeInSeconds << " seconds." << std::endl;
-	Game::generateSummary();
+	simulation.generateSummary();
 
 	// After the simulation finishes, keep the window open for user interactions
 	while (window.isOpen())
@@ -154,199 +119,74 @@ void Game::handleEvents()
 		}
 		else if (event.type == sf::Event::MouseWheelScrolled)
 		{
-			if (event.mouseWheelScroll.delta > 0)
-			{
-				// Zoom in
-				// view.zoom(0.8f);
-				std::cout << "Do some Zoom In" << '\n';
-			}
-			else
-			{
-				// Zoom out
-				std::cout << "Do some Zoom Out" << '\n';
-				// view.zoom(1.2f);
-			}
+			// Zoom in or out around the mouse pointer
+			zoomCamera(event.mouseWheelScroll.delta > 0 ? 0.8f : 1.25f, sf::Vector2i(event.mouseWheelScroll.x, event.mouseWheelScroll.y));
 		}
-	}
-}
-
-void Game::updateGameState()
-{
-	std::vector<Probe> newProbes;		   // Store new probes to add later
-	std::vector<size_t> probesToReplicate; // Store indices of probes to replicate
-
-	// Find probes that need to replicate
-	for (size_t i = 0; i < probeVector.size(); ++i)
-	{
-		if (probeVector[i].getMode() == ProbeMode::Replicate)
+		else if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left)
 		{
-			// Store the index of the probe that needs replication
-			probesToReplicate.push_back(i);
+			dragging = true;
+			dragPixel = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
 		}
-	}
-
-	// Estimate the required capacity for new probes (adjust as needed)
-	size_t estimatedReplicationCount = probesToReplicate.size();
-	newProbes.reserve(estimatedReplicationCount);
-
-	// TODO: Can we move logic together into probe class itself?
-	// Create new probes based on probesToReplicate
-
-	for (const auto &index : probesToReplicate)
-	{
-		// Run specific logic when the mode is "Replicate"
-
-		Probe &probe = probeVector[index];
-
-		// int probereplimit;
-		// probereplimit = config.getprobeIndividualReplicationLimit();
-		// so if replication count is 0, and our limit is 0 (do not replicate EQUAL TO OR GTR THAN)
-		// if replication count is 0 and our limit is 1 - replicate
-		// if replication count is 1 and our limit is 1 - do not replicate (EQUAL TO OR GTR THAN)
-
-		if (probe.getReplicationCount() >= config.getprobeIndividualReplicationLimit())
+		else if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left)
 		{
-			probe.setMode(ProbeMode::Shutdown);
+			dragging = false;
 		}
-		else
-		{ // if probe hasnt reached its replication limit, do some replicating. shouldnt we be doing this before a probe goes into replication mode?!
-			// Create a new replicated probe
-			// must be using targetStar name to generate the child probe name string.
-			// first arg is used as parent name, second string as replication location.
-
-			// Need to convert current location ID to string name. use utility class.
-			uint32_t replicationLocationID;															   // declare new varaible
-			replicationLocationID = probe.getTargetStar();											   // get the probes current target ID
-			std::string replicationLocationName = Utilities::getStarNameFromID(replicationLocationID); // pass target ID into lookup utility, returns string of system name.
-
-			std::string newName = Utilities::probeNamer((probe.getProbeName()), replicationLocationName);
-			Probe replicatedProbe(newName, probe.getX(), probe.getY(), probe.getSpeed(), theQuadTreeInstance);
-
-			replicatedProbe.setRandomTrailColor();
-
-			// Iterate through visited star systems of the original probe and add to replicated probe
-			const std::vector<VisitedStarSystem> &visitedSystems = probe.getVisitedStarSystems();
-			for (const auto &visitedSystem : visitedSystems)
-			{
-				// Set the visitedByProbe to false for this one as the child probe hasn't visited by itself.
-				replicatedProbe.addVisitedStarSystem(visitedSystem.starID, visitedSystem.coordinates, false);
-			}
-
-			// TODO: Get next target Star for current probe, pass this as a visted system to child.
-			// step 1 - to get next target, we need the findNearestUnvisitedStarInQuadTree (FNUSIQT) function
-			// step 2- FNUSIQT needs the probes current quadtree location, and a search radius. (hard code, but setup TODO into config.800 is value from other part doing same.)
-			const GalaxyQuadTreeNode *parentProbeCurrentQuadTreeLocation = probe.getCurrentQuadTreeNode();
-			// step 3 - we dont have implementation for current quadtree location! - we do now.
-			// step 4-  we also dont have anything to set the quadtree location.
-			const Star *parentProbeNextTarget = probe.findNearestUnvisitedStarInQuadTree(parentProbeCurrentQuadTreeLocation, config.getProbeSearchRadiusPixels());
-			if (parentProbeNextTarget != nullptr)
-			{
-				// step 5 - need to convert the xy into avector object
-				replicatedProbe.addVisitedStarSystem(parentProbeNextTarget->getID(), sf::Vector2f(parentProbeNextTarget->getX(), parentProbeNextTarget->getY()), false);
-
-				// debug here
-			}
-			else
-			{
-				// Handle the case where no nearest unvisited star was found
-			}
-
-			// TODO: Logic for updating star isExplored property
-
-			newProbes.emplace_back(replicatedProbe);
+		else if (event.type == sf::Event::MouseMoved && dragging)
+		{
+			// Drag the map along with the mouse
+			sf::Vector2i pixel(event.mouseMove.x, event.mouseMove.y);
+			panCamera(window.mapPixelToCoords(dragPixel, camera) - window.mapPixelToCoords(pixel, camera));
+			dragPixel = pixel;
 		}
 	}
+}
 
-	// Add new probes created during replication mode to the main probe vector
-	for (const auto &newProbe : newProbes)
-	{
-		probeVector.push_back(newProbe);
-	}
+void Game::zoomCamera(float factor, const sf::Vector2i &pixel)
+{
+	// No further than the star tiles go either way: from the whole map a few pixels across to a few stars filling the window.
+	float windowWidth = static_cast<float>(window.getSize().x);
+	float minWidth = windowWidth / std::ldexp(1.0f, StarTileLayer::MaxLevel);
+	float maxWidth = windowWidth / std::ldexp(1.0f, StarTileLayer::MinLevel);
+	float width = std::min(maxWidth, std::max(minWidth, camera.getSize().x * factor));
+
+	sf::Vector2f anchor = window.mapPixelToCoords(pixel, camera);
+	camera.setSize(camera.getSize() * (width / camera.getSize().x));
+	camera.move(anchor - window.mapPixelToCoords(pixel, camera));
+	panCamera(sf::Vector2f(0.0f, 0.0f)); // back over the map, if zooming moved off it
+}
 
-	// Move all probes after handling replication
-	for (auto &probe : probeVector)
-	{
-		probe.move(); // Execute the movement logic for each probe
-	}
+void Game::panCamera(const sf::Vector2f &offset)
+{
+	// The centre of the view is kept over the map, so it can never be lost off screen.
+	const sf::FloatRect &map = simulation.getMapBoundary();
+	sf::Vector2f centre = camera.getCenter() + offset;
+	centre.x = std::min(map.left + map.width, std::max(map.left, centre.x));
+	centre.y = std::min(map.top + map.height, std::max(map.top, centre.y));
+	camera.setCenter(centre);
+}
 
-	// Add your game logic for updating the state here
+void Game::resetCamera()
+{
+	// One map unit to a window pixel, the map's top left in the window's.
+	sf::Vector2u size = window.getSize();
+	camera.reset(sf::FloatRect(0.0f, 0.0f, static_cast<float>(size.x), static_cast<float>(size.y)));
 }
 
 void Game::render()
 {
 	window.clear();
+	window.setView(camera); // map layers follow the camera; text overlays switch to window pixels themselves
 
-	sf::Sprite starsSprite(renderSystem.getStarsTexture()); // Draw the pre-rendered stars texture
-	window.draw(starsSprite);
-	renderSystem.renderQuadtree(window, theQuadTreeInstance.getRootNode());
-
-	// render any probes that may exist in probeVector
-	for (const auto &probe : probeVector)
+	renderSystem.renderStars();
+	renderSystem.renderStarLabels();
+	if (const GalaxyQuadTree *quadTree = simulation.getQuadTree())
 	{
-		renderSystem.renderProbe(probe);
+		renderSystem.renderQuadtree(window, *quadTree);
 	}
+
+	// render any probes that may exist in the probe system
+	renderSystem.renderProbes(simulation.getProbeSystem());
 	renderSystem.calculateAndDisplayFPS();
 	window.display();
 }
 
-void Game::generateSummary() const
-{
-	// Collect and display header summary statistics here
-	std::cout << "-----------------" << '\n'
-			  << "Begin Summary: " << '\n'
-			  << "-----------------" << '\n';
-
-	if (config.getSummaryShowPerProbe())
-	{
-		for (const auto &probe : probeVector)
-		{
-			if (probe.getTotalDistanceTraveled() > 0 && probe.getReplicationCount() > 0)
-			{
-				std::cout << "- Probe Name: [" << probe.getProbeName() << "] Traveled [" << probe.getTotalDistanceTraveled() << "], replicated [" << probe.getReplicationCount() << "] times,"
-						  << "visiting ";
-
-				const std::vector<VisitedStarSystem> &visitedSystems = probe.getVisitedStarSystems();
-				for (const auto &visitedSystem : visitedSystems)
-				{
-					if (visitedSystem.visitedByProbe)
-					{
-						std::cout << "[" << visitedSystem.starID << "];";
-					}
-				}
-				std::cout << std::endl;
-			}
-		}
-	}
-	// Footer statistics if needed (total distance, total replications, etc.)
-
-	int summarySeed = config.getWorldSeed();
-	int summaryIterations = config.getSimulationIterations();
-	size_t probeCount = probeVector.size();
-
-	size_t totalStarsVisitedByProbes = 0;
-
-	for (const auto &star : galaxyVector)
-	{
-		if (star.getIsExplored())
-		{
-			totalStarsVisitedByProbes++;
-		}
-	}
-	double maxPossibleEfficiencyScore = 1;
-	double efficiencyScore = totalStarsVisitedByProbes / (simulationTimeInSeconds * probeCount);
-	double efficiencyPercentage = (efficiencyScore / maxPossibleEfficiencyScore) * 100.0;
-
-	if (config.getSummaryShowFooter())
-	{
-		// show summary footer is true
-		std::cout << "Simulation Summary:" << '\n'
-				  << "World Seed is [" << summarySeed << "] and Simulation limited to [" << summaryIterations << "] epochs" << '\n'
-				  << "Total number of stars: " << galaxyVector.size() << '\n'
-				  << "Total number of probes: " << probeCount << '\n'
-				  << "Total Simulation Time: " << simulationTimeInSeconds << " seconds." << '\n'
-				  // TODO - FIX and workout what a perfect score is on this. aparantly min number for 7 stars is 3 probes.
-				  << "Efficiency Ratio: " << efficiencyScore << '\n'
-				  << "Efficiency Percent: " << efficiencyPercentage << '\n'
-				  << "-----------------" << std::endl;
-	}
-}
\ No newline at end of file
@@ -3,11 +3,12 @@
 #define GAME_H
 
 #include "LoadConfig.h"
-#include "LoadCSVData.h"
 #include "Probe.h"
 #include "RenderSystem.h"
+#include "Simulation.h"
 #include <SFML/Graphics.hpp>
-#include "GalaxyQuadTree.h"
+#include <functional>
+#include <unordered_map>
 
 class Game
 {
@@ -20,18 +21,18 @@ public:
 private:
 	sf::RenderWindow window;
 	RenderSystem renderSystem;
-	std::vector<Star> galaxyVector;
-	// std::vector<Star> galaxyVector2;
-	std::vector<Probe> probeVector; // used to keep list of all probe objects so they can be looped through and processed for logic/render.
 
-	void handleEvents();	// will be for reading user input
-	void updateGameState(); // will be for running logic of probes and updating star system resources etc.
-	void render();			// will render the star objects from galaxyVector
-	void renderProbes();	// will render the probe positions on screen with SFML
-	void generateSummary() const;
+	void handleEvents(); // will be for reading user input
+	void render();		 // will render the star objects from galaxyVector
+	void renderProbes(); // will render the probe positions on screen with SFML
+	void zoomCamera(float factor, const sf::Vector2i &pixel); // factor > 1 zooms out; the map point under pixel stays put
+	void panCamera(const sf::Vector2f &offset);				  // in map units
+	void resetCamera();										  // the whole map, as at startup
 	const LoadConfig &config; // Member variable to hold the LoadConfig object
-	double simulationTimeInSeconds;
-	GalaxyQuadTree theQuadTreeInstance;
+	Simulation simulation;	  // star catalog, quadtree and probes; shared with headless runs
+	sf::View camera;		  // the part of the map shown in the window
+	bool dragging;			  // the map is being panned with the mouse
+	sf::Vector2i dragPixel;	  // where the mouse was at the last drag event
 	std::unordered_map<sf::Keyboard::Key, std::function<void()>> keyBindings;
 };
 
@@ -0,0 +1,263 @@
+// KdTreeIndex.cpp
+#include "KdTreeIndex.h"
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+	struct KdEntry
+	{
+		float x;
+		float y;
+		uint32_t id;		// star ID, so the order never depends on the table order it was built from
+		uint32_t starIndex; // in the table being sorted
+	};
+
+	// Could any point of rect fall in the closed box? Boxes around stars on one spot have no width, so SFML's
+	// intersects (which wants an overlap of some size) would miss them. Like contains, rect may have a negative size.
+	bool boxTouchesRect(const sf::FloatRect &box, const sf::FloatRect &rect)
+	{
+		float left = std::min(rect.left, rect.left + rect.width);
+		float right = std::max(rect.left, rect.left + rect.width);
+		float top = std::min(rect.top, rect.top + rect.height);
+		float bottom = std::max(rect.top, rect.top + rect.height);
+		return left <= box.left + box.width && box.left < right && top <= box.top + box.height && box.top < bottom;
+	}
+}
+
+KdTreeIndex::KdTreeIndex(const sf::FloatRect &boundary, int bucketSize, std::vector<Star> &starTable) : SpatialIndex(starTable),
+																									   boundary(boundary),
+																									   bucketSize(std::max(1, bucketSize))
+{
+}
+
+void KdTreeIndex::build(ThreadPool &threadPool)
+{
+	uint32_t starCount = static_cast<uint32_t>(starTable.size());
+	std::vector<KdEntry> entries(starCount);
+	threadPool.parallelFor(starCount, [&](size_t begin, size_t end)
+						   {
+		for (size_t i = begin; i < end; ++i)
+		{
+			const Star &star = starTable[i];
+			entries[i] = {static_cast<float>(star.getX()), static_cast<float>(star.getY()), star.getID(), static_cast<uint32_t>(i)};
+		} });
+
+	// Stars outside the map are kept in the table, at the end, but not indexed.
+	uint32_t insideCount = static_cast<uint32_t>(std::stable_partition(entries.begin(), entries.end(), [this](const KdEntry &entry)
+																	   { return boundary.contains(entry.x, entry.y); }) -
+												 entries.begin());
+
+	// Split breadth-first. Every comparison is a strict total order (axis, other axis, ID) and leaves are sorted
+	// the same way, so the resulting table order depends only on which stars there are, not the order they came in.
+	nodes.clear();
+	nodes.push_back({sf::FloatRect(), NoChildren, 0, insideCount});
+	for (uint32_t nodeIndex = 0; nodeIndex < nodes.size(); ++nodeIndex)
+	{
+		KdEntry *first = entries.data() + nodes[nodeIndex].firstStar;
+		KdEntry *last = first + nodes[nodeIndex].starCount;
+		if (first == last)
+		{
+			continue;
+		}
+		float minX = first->x, maxX = first->x, minY = first->y, maxY = first->y;
+		for (const KdEntry *entry = first; entry != last; ++entry)
+		{
+			minX = std::min(minX, entry->x);
+			maxX = std::max(maxX, entry->x);
+			minY = std::min(minY, entry->y);
+			maxY = std::max(maxY, entry->y);
+		}
+		nodes[nodeIndex].bounds = sf::FloatRect(minX, minY, maxX - minX, maxY - minY);
+
+		bool splitOnX = maxX - minX >= maxY - minY;
+		auto lessOnAxis = [splitOnX](const KdEntry &a, const KdEntry &b)
+		{
+			if (splitOnX)
+			{
+				return a.x != b.x ? a.x < b.x : (a.y != b.y ? a.y < b.y : a.id < b.id);
+			}
+			return a.y != b.y ? a.y < b.y : (a.x != b.x ? a.x < b.x : a.id < b.id);
+		};
+		if (nodes[nodeIndex].starCount <= static_cast<uint32_t>(bucketSize) || (minX == maxX && minY == maxY))
+		{
+			std::sort(first, last, lessOnAxis); // leaf, stars on one spot included: splitting them cannot help a search
+			continue;
+		}
+
+		uint32_t lowerCount = nodes[nodeIndex].starCount / 2;
+		std::nth_element(first, first + lowerCount, last, lessOnAxis);
+		uint32_t firstStar = nodes[nodeIndex].firstStar;
+		uint32_t upperCount = nodes[nodeIndex].starCount - lowerCount;
+		nodes[nodeIndex].firstChild = static_cast<uint32_t>(nodes.size());
+		nodes.push_back({sf::FloatRect(), NoChildren, firstStar, lowerCount});
+		nodes.push_back({sf::FloatRect(), NoChildren, firstStar + lowerCount, upperCount});
+	}
+
+	std::vector<Star> sortedStars;
+	sortedStars.reserve(starCount);
+	for (const KdEntry &entry : entries)
+	{
+		sortedStars.push_back(std::move(starTable[entry.starIndex]));
+	}
+	starTable.swap(sortedStars);
+
+	// Children come after their parent, so a backwards pass sees every child first.
+	availableStarCounts = std::vector<std::atomic<uint32_t>>(nodes.size());
+	for (size_t nodeIndex = nodes.size(); nodeIndex-- > 0;)
+	{
+		const Node &node = nodes[nodeIndex];
+		uint32_t available = 0;
+		if (node.firstChild != NoChildren)
+		{
+			available = availableStarCounts[node.firstChild].load(std::memory_order_relaxed) + availableStarCounts[node.firstChild + 1].load(std::memory_order_relaxed);
+		}
+		else
+		{
+			for (uint32_t starIndex = node.firstStar; starIndex < node.firstStar + node.starCount; ++starIndex)
+			{
+				available += starTable[starIndex].getIsAvailable() ? 1 : 0;
+			}
+		}
+		availableStarCounts[nodeIndex].store(available, std::memory_order_relaxed);
+	}
+}
+
+void KdTreeIndex::availableStarCountChanged(uint32_t starIndex, int delta)
+{
+	uint32_t nodeIndex = 0;
+	while (!nodes.empty() && starIndex >= nodes[nodeIndex].firstStar && starIndex < nodes[nodeIndex].firstStar + nodes[nodeIndex].starCount)
+	{
+		availableStarCounts[nodeIndex].fetch_add(static_cast<uint32_t>(delta), std::memory_order_relaxed);
+		if (nodes[nodeIndex].firstChild == NoChildren)
+		{
+			break;
+		}
+		const Node &lower = nodes[nodes[nodeIndex].firstChild];
+		nodeIndex = starIndex < lower.firstStar + lower.starCount ? nodes[nodeIndex].firstChild : nodes[nodeIndex].firstChild + 1;
+	}
+}
+
+void KdTreeIndex::searchNearest(const sf::Vector2f &point, size_t k, const StarFilter &filter, std::vector<uint32_t> &results, float maxDistance, uint32_t, bool availableOnly) const
+{
+	results.clear();
+	if (k == 0 || nodes.empty())
+	{
+		return;
+	}
+
+	static thread_local NearestCandidates candidates;
+	static thread_local std::vector<uint32_t> stack;
+	candidates.reset(k, maxDistance * maxDistance);
+	stack.assign(1, 0);
+	while (!stack.empty())
+	{
+		uint32_t nodeIndex = stack.back();
+		stack.pop_back();
+		const Node &node = nodes[nodeIndex];
+		if ((availableOnly && availableStarCounts[nodeIndex].load(std::memory_order_relaxed) == 0) || node.starCount == 0 || distanceSquaredToRect(point, node.bounds) > candidates.getBound())
+		{
+			continue;
+		}
+
+		if (node.firstChild == NoChildren)
+		{
+			for (uint32_t starIndex = node.firstStar; starIndex < node.firstStar + node.starCount; ++starIndex)
+			{
+				const Star &star = starTable[starIndex];
+				if (availableOnly && !star.getIsAvailable())
+				{
+					continue;
+				}
+				float dx = star.getX() - point.x;
+				float dy = star.getY() - point.y;
+				float distanceSquared = dx * dx + dy * dy;
+				if (distanceSquared <= candidates.getBound() && filter(starIndex))
+				{
+					candidates.offer(distanceSquared, starIndex);
+				}
+			}
+			continue;
+		}
+
+		// The stack is last in, first out, so push the nearer child last.
+		uint32_t lower = node.firstChild;
+		uint32_t upper = node.firstChild + 1;
+		if (distanceSquaredToRect(point, nodes[lower].bounds) <= distanceSquaredToRect(point, nodes[upper].bounds))
+		{
+			std::swap(lower, upper);
+		}
+		stack.push_back(lower);
+		stack.push_back(upper);
+	}
+	candidates.copyTo(results);
+}
+
+void KdTreeIndex::findInRadius(const sf::Vector2f &center, float radius, std::vector<uint32_t> &results) const
+{
+	results.clear();
+	if (nodes.empty())
+	{
+		return;
+	}
+	float radiusSquared = radius * radius;
+	static thread_local std::vector<uint32_t> stack;
+	stack.assign(1, 0);
+	while (!stack.empty())
+	{
+		const Node &node = nodes[stack.back()];
+		stack.pop_back();
+		if (node.starCount == 0 || distanceSquaredToRect(center, node.bounds) > radiusSquared)
+		{
+			continue;
+		}
+		if (node.firstChild != NoChildren)
+		{
+			stack.push_back(node.firstChild);
+			stack.push_back(node.firstChild + 1);
+			continue;
+		}
+		for (uint32_t starIndex = node.firstStar; starIndex < node.firstStar + node.starCount; ++starIndex)
+		{
+			float dx = starTable[starIndex].getX() - center.x;
+			float dy = starTable[starIndex].getY() - center.y;
+			if (dx * dx + dy * dy <= radiusSquared)
+			{
+				results.push_back(starIndex);
+			}
+		}
+	}
+}
+
+void KdTreeIndex::findInRect(const sf::FloatRect &rect, std::vector<uint32_t> &results) const
+{
+	results.clear();
+	if (nodes.empty())
+	{
+		return;
+	}
+	static thread_local std::vector<uint32_t> stack;
+	stack.assign(1, 0);
+	while (!stack.empty())
+	{
+		const Node &node = nodes[stack.back()];
+		stack.pop_back();
+		if (node.starCount == 0 || !boxTouchesRect(node.bounds, rect))
+		{
+			continue;
+		}
+		if (node.firstChild != NoChildren)
+		{
+			stack.push_back(node.firstChild);
+			stack.push_back(node.firstChild + 1);
+			continue;
+		}
+		for (uint32_t starIndex = node.firstStar; starIndex < node.firstStar + node.starCount; ++starIndex)
+		{
+			if (rect.contains(starTable[starIndex].getX(), starTable[starIndex].getY()))
+			{
+				results.push_back(starIndex);
+			}
+		}
+	}
+}
@@ -0,0 +1,46 @@
+// KdTreeIndex.h
+#ifndef KDTREEINDEX_H
+#define KDTREEINDEX_H
+
+#include "SpatialIndex.h"
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Spatial index "kdtree": a static k-d tree. Each node splits its stars in half at the median of the axis its
+// stars spread furthest along, until at most bucketSize are left, so the tree stays balanced however clustered the
+// catalog is. As with the quadtree, each node is one run of the reordered star table and keeps a count of the
+// available stars under it.
+class KdTreeIndex : public SpatialIndex
+{
+public:
+	KdTreeIndex(const sf::FloatRect &boundary, int bucketSize, std::vector<Star> &starTable);
+
+	void build(ThreadPool &threadPool) override;
+	void findInRadius(const sf::Vector2f &center, float radius, std::vector<uint32_t> &results) const override;
+	void findInRect(const sf::FloatRect &rect, std::vector<uint32_t> &results) const override;
+
+protected:
+	// Depth first, nearer child first, skipping nodes whose bounding box is further away than the k-th best so far.
+	void searchNearest(const sf::Vector2f &point, size_t k, const StarFilter &filter, std::vector<uint32_t> &results, float maxDistance, uint32_t hint, bool availableOnly) const override;
+	void availableStarCountChanged(uint32_t starIndex, int delta) override;
+
+private:
+	static constexpr uint32_t NoChildren = std::numeric_limits<uint32_t>::max();
+
+	struct Node
+	{
+		sf::FloatRect bounds; // tight box around the node's stars
+		uint32_t firstChild;  // two consecutive children (lower half first), NoChildren for a leaf
+		uint32_t firstStar;	  // stars [firstStar, firstStar + starCount) of the star table
+		uint32_t starCount;
+	};
+
+	sf::FloatRect boundary;
+	int bucketSize;
+	std::vector<Node> nodes;								// nodes[0] is the root, children always after their parent
+	std::vector<std::atomic<uint32_t>> availableStarCounts; // per node
+};
+
+#endif // KDTREEINDEX_H
@@ -0,0 +1,373 @@
+// LabelLayer.cpp
+#include "LabelLayer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	const int CellSize = 8; // pixels per side of the cells overlap is checked on
+}
+
+LabelLayer::LabelLayer(const sf::Font &font, unsigned int characterSize, const sf::Vector2f &offset) : font(font),
+																										characterSize(characterSize),
+																										offset(offset),
+																										liveVertexCount(0),
+																										hiddenVertexCount(0),
+																										columns(0),
+																										rows(0),
+																										layoutDirty(true),
+																										layoutViewRotation(0.0f)
+{
+}
+
+size_t LabelLayer::size() const
+{
+	return labels.size();
+}
+
+void LabelLayer::resize(size_t labelCount)
+{
+	if (labelCount == labels.size())
+	{
+		return;
+	}
+	for (size_t index = labelCount; index < labels.size(); ++index)
+	{
+		liveVertexCount -= labels[index].shaped ? labels[index].vertexCount : 0;
+	}
+	labels.resize(labelCount, Label{std::string(), sf::Color::White, sf::Vector2f(), sf::Vector2f(), 0, 0, sf::Vector2f(), 0, false, false, false});
+	layoutDirty = true;
+}
+
+void LabelLayer::setLabel(size_t index, const std::string &text, const sf::Color &colour)
+{
+	Label &label = labels[index];
+	if (label.text == text && label.colour == colour)
+	{
+		return;
+	}
+	label.text = text;
+	label.colour = colour;
+	if (label.shaped)
+	{
+		// The old glyphs are left where they are. Once most of the store is such leftovers, it is emptied and
+		// everything still shown is shaped again as the layout gets to it.
+		label.shaped = false;
+		liveVertexCount -= label.vertexCount;
+		if (liveVertexCount < glyphVertices.size() / 2)
+		{
+			for (Label &other : labels)
+			{
+				other.shaped = false;
+			}
+			glyphVertices.clear();
+			liveVertexCount = 0;
+		}
+	}
+	layoutDirty = true;
+}
+
+void LabelLayer::setAnchor(size_t index, const sf::Vector2f &position)
+{
+	Label &label = labels[index];
+	if (label.anchor == position)
+	{
+		return;
+	}
+	label.anchor = position;
+	if (!layoutDirty && !label.moved)
+	{
+		label.moved = true;
+		movedLabels.push_back(static_cast<uint32_t>(index));
+	}
+}
+
+void LabelLayer::shape(Label &label)
+{
+	// Glyphs are placed as sf::Text places them on a single line: each quad hangs off the baseline, one advance
+	// (plus kerning) after the last. Spaces only advance.
+	label.firstVertex = static_cast<uint32_t>(glyphVertices.size());
+	float x = 0.0f;
+	float baseline = static_cast<float>(characterSize);
+	sf::Uint32 previous = 0;
+	for (char character : label.text)
+	{
+		sf::Uint32 codePoint = static_cast<unsigned char>(character);
+		x += font.getKerning(previous, codePoint, characterSize);
+		previous = codePoint;
+		const sf::Glyph &glyph = font.getGlyph(codePoint, characterSize, false);
+		if (glyph.bounds.width > 0.0f && glyph.bounds.height > 0.0f)
+		{
+			float left = x + glyph.bounds.left;
+			float top = baseline + glyph.bounds.top;
+			float right = left + glyph.bounds.width;
+			float bottom = top + glyph.bounds.height;
+			float textureLeft = static_cast<float>(glyph.textureRect.left);
+			float textureTop = static_cast<float>(glyph.textureRect.top);
+			float textureRight = textureLeft + glyph.textureRect.width;
+			float textureBottom = textureTop + glyph.textureRect.height;
+			glyphVertices.push_back(sf::Vertex(sf::Vector2f(left, top), label.colour, sf::Vector2f(textureLeft, textureTop)));
+			glyphVertices.push_back(sf::Vertex(sf::Vector2f(right, top), label.colour, sf::Vector2f(textureRight, textureTop)));
+			glyphVertices.push_back(sf::Vertex(sf::Vector2f(right, bottom), label.colour, sf::Vector2f(textureRight, textureBottom)));
+			glyphVertices.push_back(sf::Vertex(sf::Vector2f(left, bottom), label.colour, sf::Vector2f(textureLeft, textureBottom)));
+		}
+		x += glyph.advance;
+	}
+	label.vertexCount = static_cast<uint32_t>(glyphVertices.size()) - label.firstVertex;
+	label.size = sf::Vector2f(x, font.getLineSpacing(characterSize));
+	label.shaped = true;
+	largestLabelSize.x = std::max(largestLabelSize.x, label.size.x);
+	largestLabelSize.y = std::max(largestLabelSize.y, label.size.y);
+	liveVertexCount += label.vertexCount;
+}
+
+bool LabelLayer::viewChanged(const sf::RenderTarget &target) const
+{
+	const sf::View &view = target.getView();
+	return target.getSize() != layoutTargetSize || view.getCenter() != layoutViewCenter || view.getSize() != layoutViewSize ||
+		   view.getRotation() != layoutViewRotation || view.getViewport() != layoutViewport;
+}
+
+void LabelLayer::layout(const sf::RenderTarget &target)
+{
+	layoutTargetSize = target.getSize();
+	columns = static_cast<int>(layoutTargetSize.x) / CellSize + 1;
+	rows = static_cast<int>(layoutTargetSize.y) / CellSize + 1;
+	occupiedCells.assign(static_cast<size_t>(columns) * rows, 0);
+	waitingLabels.resize(occupiedCells.size());
+	for (std::vector<uint32_t> &waiting : waitingLabels)
+	{
+		waiting.clear();
+	}
+	batch.clear();
+	hiddenVertexCount = 0;
+
+	const sf::View &view = target.getView();
+	for (uint32_t index = 0; index < labels.size(); ++index)
+	{
+		Label &label = labels[index];
+		label.placed = false;
+		label.moved = false;
+		if (label.text.empty())
+		{
+			continue;
+		}
+		sf::Vector2i pixel = target.mapCoordsToPixel(label.anchor, view);
+		label.screenPosition = sf::Vector2f(pixel.x + offset.x, pixel.y + offset.y);
+		place(index);
+	}
+	movedLabels.clear();
+
+	layoutDirty = false;
+	layoutViewCenter = view.getCenter();
+	layoutViewSize = view.getSize();
+	layoutViewRotation = view.getRotation();
+	layoutViewport = view.getViewport();
+}
+
+void LabelLayer::moveLabels(const sf::RenderTarget &target)
+{
+	const sf::View &view = target.getView();
+	std::sort(movedLabels.begin(), movedLabels.end());
+	freedCells.clear();
+	for (uint32_t index : movedLabels)
+	{
+		Label &label = labels[index];
+		label.moved = false;
+		if (label.text.empty())
+		{
+			continue;
+		}
+		sf::Vector2i pixel = target.mapCoordsToPixel(label.anchor, view);
+		sf::Vector2f screenPosition(pixel.x + offset.x, pixel.y + offset.y);
+		if (screenPosition == label.screenPosition) // moved less than a pixel
+		{
+			continue;
+		}
+		if (!label.placed)
+		{
+			if (std::vector<uint32_t> *waiting = waitingAt(label.screenPosition))
+			{
+				waiting->erase(std::remove(waiting->begin(), waiting->end(), index), waiting->end());
+			}
+			label.screenPosition = screenPosition;
+			place(index);
+			continue;
+		}
+
+		// Off its old cells, then onto the new ones if they are free, in which case its glyphs are just shifted.
+		// Otherwise they are collapsed to nothing, to be dropped the next time the batch is rebuilt.
+		sf::IntRect oldCells = coveredCells(label);
+		setCells(oldCells, 0);
+		freedCells.push_back(oldCells);
+		sf::Vector2f shift(std::floor(screenPosition.x) - std::floor(label.screenPosition.x), std::floor(screenPosition.y) - std::floor(label.screenPosition.y));
+		label.screenPosition = screenPosition;
+		sf::Vertex *vertices = batch.data() + label.batchVertex;
+		bool onScreen = screenPosition.x >= 0.0f && screenPosition.y >= 0.0f && screenPosition.x < layoutTargetSize.x && screenPosition.y < layoutTargetSize.y;
+		sf::IntRect cells = coveredCells(label);
+		if (onScreen && cellsFree(cells))
+		{
+			setCells(cells, 1);
+			for (uint32_t vertex = 0; vertex < label.vertexCount; ++vertex)
+			{
+				vertices[vertex].position += shift;
+			}
+			continue;
+		}
+		for (uint32_t vertex = 0; vertex < label.vertexCount; ++vertex)
+		{
+			vertices[vertex].position = vertices[0].position;
+		}
+		label.placed = false;
+		hiddenVertexCount += label.vertexCount;
+		if (std::vector<uint32_t> *waiting = waitingAt(screenPosition))
+		{
+			waiting->push_back(index);
+		}
+	}
+	movedLabels.clear();
+
+	if (hiddenVertexCount > batch.size() / 2)
+	{
+		layout(target);
+		return;
+	}
+
+	// Room left behind goes to labels that were crowded out, as a layout would give it: those starting in a freed
+	// cell, or far enough up or left of one to reach it, in index order. Their screen positions are still good,
+	// as neither they nor the view have moved. Any that still do not fit wait again.
+	int reachColumns = static_cast<int>(largestLabelSize.x) / CellSize + 1;
+	int reachRows = static_cast<int>(largestLabelSize.y) / CellSize + 1;
+	retryLabels.clear();
+	for (const sf::IntRect &cells : freedCells)
+	{
+		for (int row = std::max(0, cells.top - reachRows); row < cells.top + cells.height; ++row)
+		{
+			for (int column = std::max(0, cells.left - reachColumns); column < cells.left + cells.width; ++column)
+			{
+				std::vector<uint32_t> &waiting = waitingLabels[static_cast<size_t>(row) * columns + column];
+				retryLabels.insert(retryLabels.end(), waiting.begin(), waiting.end());
+				waiting.clear();
+			}
+		}
+	}
+	std::sort(retryLabels.begin(), retryLabels.end());
+	retryLabels.erase(std::unique(retryLabels.begin(), retryLabels.end()), retryLabels.end());
+	for (uint32_t index : retryLabels)
+	{
+		if (!labels[index].placed)
+		{
+			place(index);
+		}
+	}
+}
+
+bool LabelLayer::place(uint32_t index)
+{
+	Label &label = labels[index];
+	const sf::Vector2f &topLeft = label.screenPosition;
+	if (topLeft.x < 0.0f || topLeft.y < 0.0f || topLeft.x >= layoutTargetSize.x || topLeft.y >= layoutTargetSize.y)
+	{
+		return false;
+	}
+	// Checking the first cell before shaping means labels that are always crowded out are never shaped.
+	int firstColumn = static_cast<int>(topLeft.x) / CellSize;
+	int firstRow = static_cast<int>(topLeft.y) / CellSize;
+	std::vector<uint32_t> &waiting = waitingLabels[static_cast<size_t>(firstRow) * columns + firstColumn];
+	if (occupiedCells[static_cast<size_t>(firstRow) * columns + firstColumn] != 0)
+	{
+		waiting.push_back(index);
+		return false;
+	}
+	if (!label.shaped)
+	{
+		shape(label);
+	}
+	sf::IntRect cells = coveredCells(label);
+	if (!cellsFree(cells))
+	{
+		waiting.push_back(index);
+		return false;
+	}
+	setCells(cells, 1);
+
+	// Snap to whole pixels so glyphs stay sharp.
+	sf::Vector2f position(std::floor(topLeft.x), std::floor(topLeft.y));
+	label.placed = true;
+	label.batchVertex = static_cast<uint32_t>(batch.size());
+	for (uint32_t vertex = label.firstVertex; vertex < label.firstVertex + label.vertexCount; ++vertex)
+	{
+		sf::Vertex placed = glyphVertices[vertex];
+		placed.position += position;
+		batch.push_back(placed);
+	}
+	return true;
+}
+
+std::vector<uint32_t> *LabelLayer::waitingAt(const sf::Vector2f &topLeft)
+{
+	if (topLeft.x < 0.0f || topLeft.y < 0.0f || topLeft.x >= layoutTargetSize.x || topLeft.y >= layoutTargetSize.y)
+	{
+		return nullptr;
+	}
+	int column = static_cast<int>(topLeft.x) / CellSize;
+	int row = static_cast<int>(topLeft.y) / CellSize;
+	return &waitingLabels[static_cast<size_t>(row) * columns + column];
+}
+
+sf::IntRect LabelLayer::coveredCells(const Label &label) const
+{
+	int firstColumn = static_cast<int>(label.screenPosition.x) / CellSize;
+	int firstRow = static_cast<int>(label.screenPosition.y) / CellSize;
+	int lastColumn = std::min(columns - 1, static_cast<int>(label.screenPosition.x + label.size.x) / CellSize);
+	int lastRow = std::min(rows - 1, static_cast<int>(label.screenPosition.y + label.size.y) / CellSize);
+	return sf::IntRect(firstColumn, firstRow, lastColumn - firstColumn + 1, lastRow - firstRow + 1);
+}
+
+bool LabelLayer::cellsFree(const sf::IntRect &cells) const
+{
+	for (int row = cells.top; row < cells.top + cells.height; ++row)
+	{
+		for (int column = cells.left; column < cells.left + cells.width; ++column)
+		{
+			if (occupiedCells[static_cast<size_t>(row) * columns + column] != 0)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void LabelLayer::setCells(const sf::IntRect &cells, uint8_t occupied)
+{
+	for (int row = cells.top; row < cells.top + cells.height; ++row)
+	{
+		std::fill_n(occupiedCells.begin() + static_cast<size_t>(row) * columns + cells.left, cells.width, occupied);
+	}
+}
+
+void LabelLayer::draw(sf::RenderTarget &target)
+{
+	if (layoutDirty || viewChanged(target))
+	{
+		layout(target);
+	}
+	else if (!movedLabels.empty())
+	{
+		moveLabels(target);
+	}
+	if (batch.empty())
+	{
+		return;
+	}
+
+	// The batch is in screen pixels, so draw it through a view of the whole target with one unit to the pixel.
+	sf::View previousView = target.getView();
+	sf::Vector2u targetSize = target.getSize();
+	target.setView(sf::View(sf::FloatRect(0.0f, 0.0f, static_cast<float>(targetSize.x), static_cast<float>(targetSize.y))));
+	sf::RenderStates states;
+	states.texture = &font.getTexture(characterSize);
+	target.draw(batch.data(), batch.size(), sf::Quads, states);
+	target.setView(previousView);
+}
@@ -0,0 +1,79 @@
+// LabelLayer.h
+#ifndef LABELLAYER_H
+#define LABELLAYER_H
+
+#include <SFML/Graphics.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Text labels pinned to points on the map, drawn together in one call as quads cut from the font's glyph texture
+// (the atlas sf::Font already keeps for each character size). Labels are laid out in screen pixels, so they stay
+// the same size at any zoom, in index order: a label that would start off screen or overlap one already placed is
+// skipped, so crowded areas show a readable few rather than a smear. A label is shaped the first time it gets
+// that far and kept from then on; the layout is only redone when labels change or the view does. A label that
+// moves keeps its glyphs in place in the batch, shifted, if its new spot is free, and is hidden otherwise; any
+// room it leaves goes to labels that were crowded out, in index order.
+class LabelLayer
+{
+public:
+	LabelLayer(const sf::Font &font, unsigned int characterSize, const sf::Vector2f &offset); // offset from the anchor to the label's top left, in pixels
+
+	size_t size() const;
+	void resize(size_t labelCount);												  // new labels are blank
+	void setLabel(size_t index, const std::string &text, const sf::Color &colour); // reshaped only if either changed
+	void setAnchor(size_t index, const sf::Vector2f &position);					  // in map coordinates, ignored if unchanged
+	void draw(sf::RenderTarget &target);
+
+private:
+	struct Label
+	{
+		std::string text;
+		sf::Color colour;
+		sf::Vector2f anchor;
+		sf::Vector2f size;	  // of the shaped text, in pixels
+		uint32_t firstVertex; // the shaped text is glyphVertices [firstVertex, firstVertex + vertexCount), relative to its top left
+		uint32_t vertexCount;
+		sf::Vector2f screenPosition; // its top left on screen, in pixels, as of the last layout or move
+		uint32_t batchVertex;		 // while placed, its glyphs are batch [batchVertex, batchVertex + vertexCount)
+		bool shaped;
+		bool placed;
+		bool moved; // anchor changed since the last layout or move
+	};
+
+	void shape(Label &label);
+	void layout(const sf::RenderTarget &target);
+	void moveLabels(const sf::RenderTarget &target); // re-place just the labels in movedLabels
+	bool place(uint32_t index);						 // add the label at its screen position to the batch, if it is on screen and has room
+	std::vector<uint32_t> *waitingAt(const sf::Vector2f &topLeft); // the waitingLabels for a top left, or nullptr off screen
+	sf::IntRect coveredCells(const Label &label) const;
+	bool cellsFree(const sf::IntRect &cells) const;
+	void setCells(const sf::IntRect &cells, uint8_t occupied);
+	bool viewChanged(const sf::RenderTarget &target) const;
+
+	const sf::Font &font;
+	unsigned int characterSize;
+	sf::Vector2f offset;
+	std::vector<Label> labels;
+	std::vector<sf::Vertex> glyphVertices; // shaped labels, four per glyph
+	size_t liveVertexCount;				   // the part of glyphVertices still used by a label, the rest was left by reshaping
+	std::vector<sf::Vertex> batch;		   // the placed labels, in screen pixels
+	size_t hiddenVertexCount;			   // the part of batch left as empty quads by labels moved out of their place
+	std::vector<uint8_t> occupiedCells;	   // screen cells covered by a placed label
+	int columns;						   // of occupiedCells
+	int rows;
+	std::vector<std::vector<uint32_t>> waitingLabels; // per cell, the labels crowded out with their top left in it
+	sf::Vector2f largestLabelSize;					  // of any label shaped, so how far up and left of a cell labels covering it start
+	std::vector<uint32_t> movedLabels;				  // labels to re-place before the next draw
+	std::vector<sf::IntRect> freedCells;			  // scratch for moveLabels
+	std::vector<uint32_t> retryLabels;
+	bool layoutDirty;
+	sf::Vector2u layoutTargetSize; // what the last layout was made for
+	sf::Vector2f layoutViewCenter;
+	sf::Vector2f layoutViewSize;
+	float layoutViewRotation;
+	sf::FloatRect layoutViewport;
+};
+
+#endif // LABELLAYER_H
@@ -0,0 +1,66 @@
+// LeafScan.cpp
+#include "LeafScan.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LEAFSCAN_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LEAFSCAN_SSE2
+#endif
+
+namespace LeafScan
+{
+	uint64_t scanBlock(const float *xs, const float *ys, const uint32_t *availableMasks, uint32_t count, const sf::Vector2f &point, float maxDistanceSquared, float *distancesSquared)
+	{
+		uint64_t mask = 0;
+		uint32_t i = 0;
+
+#if defined(LEAFSCAN_AVX2)
+		const __m256 pointX = _mm256_set1_ps(point.x);
+		const __m256 pointY = _mm256_set1_ps(point.y);
+		const __m256 bound = _mm256_set1_ps(maxDistanceSquared);
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 dx = _mm256_sub_ps(_mm256_loadu_ps(xs + i), pointX);
+			__m256 dy = _mm256_sub_ps(_mm256_loadu_ps(ys + i), pointY);
+			__m256 distanceSquared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+			_mm256_storeu_ps(distancesSquared + i, distanceSquared);
+			__m256 within = _mm256_cmp_ps(distanceSquared, bound, _CMP_LE_OQ);
+			if (availableMasks != nullptr)
+			{
+				within = _mm256_and_ps(within, _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(availableMasks + i))));
+			}
+			mask |= static_cast<uint64_t>(_mm256_movemask_ps(within)) << i;
+		}
+#elif defined(LEAFSCAN_SSE2)
+		const __m128 pointX = _mm_set1_ps(point.x);
+		const __m128 pointY = _mm_set1_ps(point.y);
+		const __m128 bound = _mm_set1_ps(maxDistanceSquared);
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + i), pointX);
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + i), pointY);
+			__m128 distanceSquared = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+			_mm_storeu_ps(distancesSquared + i, distanceSquared);
+			__m128 within = _mm_cmple_ps(distanceSquared, bound);
+			if (availableMasks != nullptr)
+			{
+				within = _mm_and_ps(within, _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(availableMasks + i))));
+			}
+			mask |= static_cast<uint64_t>(_mm_movemask_ps(within)) << i;
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			float dx = xs[i] - point.x;
+			float dy = ys[i] - point.y;
+			float distanceSquared = dx * dx + dy * dy;
+			distancesSquared[i] = distanceSquared;
+			bool available = availableMasks == nullptr || availableMasks[i] != 0;
+			mask |= static_cast<uint64_t>(distanceSquared <= maxDistanceSquared && available) << i;
+		}
+		return mask;
+	}
+}
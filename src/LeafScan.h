@@ -0,0 +1,21 @@
+// LeafScan.h
+#ifndef LEAFSCAN_H
+#define LEAFSCAN_H
+
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+
+// The inner loop of every nearest-star search: squared distances from one point to a run of stars stored as packed
+// coordinate arrays. Uses AVX2 when the build targets it (see ENABLE_AVX2 in CMakeLists.txt), SSE2 on any other
+// x86-64 build and plain C++ elsewhere.
+namespace LeafScan
+{
+	const uint32_t BlockSize = 64; // stars per call, one bit each in the returned mask
+
+	// Writes the squared distance from point to each of count (at most BlockSize) stars to distancesSquared, and
+	// returns a mask with bit i set if star i is within maxDistanceSquared and availableMasks[i] is all ones.
+	// availableMasks may be null, to ignore availability.
+	uint64_t scanBlock(const float *xs, const float *ys, const uint32_t *availableMasks, uint32_t count, const sf::Vector2f &point, float maxDistanceSquared, float *distancesSquared);
+}
+
+#endif // LEAFSCAN_H
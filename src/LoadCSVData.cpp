@@ -1,113 +1,184 @@
 // LoadCSVData.cpp
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <charconv>
 #include <vector>
 #include <string>
 #include <iostream>
 #include "LoadCSVData.h"
+#include "MappedFile.h"
+#include <cctype>
+#include <cerrno>
 #include <cmath>
-#include <SFML/Graphics/RenderWindow.hpp>
+#include <cstdlib>
+#include <cstring>
 
 #ifndef M_PI
 #define M_PI (3.14159265358979323846)
 #endif
 
-std::vector<Star> LoadCSVData::loadStarsFromCsv(const std::string &csvFilePath, sf::RenderWindow &window, const LoadConfig &config)
+std::vector<Star> LoadCSVData::loadStarsFromCsv(const std::string &csvFilePath, const sf::Vector2u &mapSize, const LoadConfig &config, ThreadPool &threadPool)
 {
 	std::vector<Star> stars;
-	std::ifstream csvFile(csvFilePath);
-	std::string line;
+	// The file is parsed in place from the mapping: fields are views into it, and only the star names get copied.
+	MappedFile csvFile(csvFilePath);
 
-	sf::Vector2u windowSize = window.getSize();
-
-	float center_x = windowSize.x / 2.0f;
-	float center_y = windowSize.y / 2.0f;
+	StarProjection projection;
+	projection.centerX = mapSize.x / 2.0f;
+	projection.centerY = mapSize.y / 2.0f;
 
 	const float dataScalingFactor = config.getScaleFactor();			   // The config scale value is how many parsecs you want to view on screen.
-	const float syntheticScalingFactor = windowSize.x / dataScalingFactor; // The data is then plotted X + Y to scale into the available resolution.
-	const float scaling_factor_x = syntheticScalingFactor;
-	const float scaling_factor_y = syntheticScalingFactor; // Keep same as X so to keep map "square"
+	const float syntheticScalingFactor = mapSize.x / dataScalingFactor; // The data is then plotted X + Y to scale into the available resolution.
+	projection.scaleX = syntheticScalingFactor;
+	projection.scaleY = syntheticScalingFactor; // Keep same as X so to keep map "square"
+
+	if (!csvFile.isOpen())
+	{
+		std::cerr << "Error opening CSV file: " << csvFilePath << std::endl;
+		return stars;
+	}
+
+	size_t dataLoaderStarsLimit = config.getLoadStarsLimit() > 0 ? static_cast<size_t>(config.getLoadStarsLimit()) : 0;
+
+	std::string_view contents = csvFile.getContents();
+	const char *begin = contents.data();
+	const char *end = contents.data() + contents.size();
+
+	// Skip the header line
+	CsvField header[1];
+	size_t headerFieldCount = 0;
+	begin = splitRow(begin, end, header, 1, headerFieldCount);
+
+	// Cut the file into roughly equal byte ranges, then move each cut forward to the start of a row. A line break
+	// only ends a row if it is outside quotes, so each range's quote count is added up first to know whether its
+	// first byte is inside a quoted field. Small files are not worth splitting.
+	const size_t minimumChunkBytes = 1 << 20;
+	size_t byteCount = static_cast<size_t>(end - begin);
+	size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threadPool.getThreadCount() * 4, byteCount / minimumChunkBytes));
+	std::vector<const char *> chunkStarts(chunkCount + 1);
+	std::vector<size_t> chunkQuoteCounts(chunkCount);
+	for (size_t chunk = 0; chunk <= chunkCount; ++chunk)
+	{
+		chunkStarts[chunk] = begin + byteCount * chunk / chunkCount;
+	}
+	threadPool.parallelFor(chunkCount, [&](size_t first, size_t last)
+						   {
+		for (size_t chunk = first; chunk < last; ++chunk)
+		{
+			chunkQuoteCounts[chunk] = std::count(chunkStarts[chunk], chunkStarts[chunk + 1], '"');
+		} });
+
+	std::vector<const char *> rowStarts(chunkCount + 1);
+	std::vector<size_t> quotesBefore(chunkCount);
+	size_t quoteCount = 0;
+	for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+	{
+		quotesBefore[chunk] = quoteCount;
+		quoteCount += chunkQuoteCounts[chunk];
+	}
+	rowStarts[0] = begin;
+	rowStarts[chunkCount] = end;
+	threadPool.parallelFor(chunkCount, [&](size_t first, size_t last)
+						   {
+		for (size_t chunk = std::max<size_t>(first, 1); chunk < last; ++chunk)
+		{
+			rowStarts[chunk] = findRowStart(chunkStarts[chunk], end, quotesBefore[chunk] % 2 != 0);
+		} });
+
+	// Parse the chunks in parallel, projection and colour included. No chunk can need more than the whole limit.
+	std::vector<std::vector<Star>> chunkStars(chunkCount);
+	std::vector<int> chunkSkippedRows(chunkCount);
+	threadPool.parallelFor(chunkCount, [&](size_t first, size_t last)
+						   {
+		for (size_t chunk = first; chunk < last; ++chunk)
+		{
+			// A row that spans a whole chunk leaves it with no row start of its own, and so empty.
+			const char *chunkEnd = std::max(rowStarts[chunk], rowStarts[chunk + 1]);
+			chunkSkippedRows[chunk] = parseRows(rowStarts[chunk], chunkEnd, projection, dataLoaderStarsLimit, chunkStars[chunk]);
+		} });
+
+	// Merge in file order, so star order (and which stars the limit keeps) is the same as a single pass.
+	int skippedRows = 0;
+	size_t totalStars = 0;
+	for (size_t chunk = 0; chunk < chunkCount; ++chunk)
+	{
+		totalStars += chunkStars[chunk].size();
+		skippedRows += chunkSkippedRows[chunk];
+	}
+	stars.reserve(std::min(totalStars, dataLoaderStarsLimit));
+	for (size_t chunk = 0; chunk < chunkCount && stars.size() < dataLoaderStarsLimit; ++chunk)
+	{
+		size_t take = std::min(chunkStars[chunk].size(), dataLoaderStarsLimit - stars.size());
+		stars.insert(stars.end(), chunkStars[chunk].begin(), chunkStars[chunk].begin() + take);
+		std::vector<Star>().swap(chunkStars[chunk]); // release as we go, the chunks add up to a second copy of the catalog
+	}
 
+	if (skippedRows > 0)
+	{
+		std::cerr << "Skipped " << skippedRows << " rows with missing or invalid fields in " << csvFilePath << std::endl;
+	}
+	return stars;
+}
+
+int LoadCSVData::parseRows(const char *cursor, const char *end, const StarProjection &projection, size_t starLimit, std::vector<Star> &stars)
+{
 	// Define the column indices based on your CSV structure (The code indexes first column as zero)
 	const int NAME_INDEX0 = 0;	 // "id" column for the id value
 	const int NAME_INDEX6 = 6;	 // "proper" column for the name
 	const int NAME_INDEX7 = 7;	 // "ra" column for the right assention (Hours)
-	const int NAME_INDEX8 = 8;	 // "dec" column for the declination
 	const int NAME_INDEX9 = 9;	 // "dist" column for the distance (Parsecs)
 	const int NAME_INDEX13 = 13; // "mag" column for the apparant magnitude (visibility from earth)
 	const int NAME_INDEX15 = 15; // "spect" column for the spectral type (K, M etc)
 	const int NAME_INDEX16 = 16; // "ci" column for the colour index
+	const size_t USED_COLUMNS = NAME_INDEX16 + 1; // only the columns up to here are kept, the rest of each row is skipped
 
-	if (!csvFile.is_open())
-	{
-		std::cerr << "Error opening CSV file: " << csvFilePath << std::endl;
-		return stars;
-	}
-
-	int loadedStars = 0; // Counter for the number of loaded stars
-	int dataLoaderStarsLimit;
-	dataLoaderStarsLimit = config.getLoadStarsLimit();
-
-	// Skip the header line
-	std::getline(csvFile, line);
+	int skippedRows = 0; // rows with a missing or unreadable id, ra, dist or mag
+	CsvField fields[USED_COLUMNS];
+	size_t fieldCount = 0;
 
-	while (std::getline(csvFile, line) && loadedStars < dataLoaderStarsLimit)
+	while (cursor < end && stars.size() < starLimit)
 	{
-		std::stringstream ss(line);
-		std::string field;
-		std::vector<std::string> fields;
-
-		// Split the line into comma-separated fields
-		while (getline(ss, field, ','))
+		cursor = splitRow(cursor, end, fields, USED_COLUMNS, fieldCount);
+		if (fieldCount < USED_COLUMNS)
 		{
-			fields.push_back(field);
+			// Blank or truncated line, nothing to read (a blank line comes back as a single empty field).
+			if (fieldCount > 1 || !fields[0].text.empty())
+			{
+				skippedRows++;
+			}
+			continue;
 		}
 
-		// Extract and convert fields
+		// Extract and convert fields. Only the columns used below are parsed.
 
 		// Assign the id column as star unique identifier. needs converting from string to uint32.
-		// std::cout << "Field column Value: " << fields[0] << std::endl; // useful debug.
-		std::string newStarIDAsString = fields[NAME_INDEX0];
 		uint32_t newStarID;
-
-		try
+		float starAppMagnitude;
+		float raHours;
+		float distance_parsecs;
+		if (!parseUnsigned(fields[NAME_INDEX0].text, newStarID) ||
+			!parseFloat(fields[NAME_INDEX13].text, starAppMagnitude) ||
+			!parseFloat(fields[NAME_INDEX7].text, raHours) ||
+			!parseFloat(fields[NAME_INDEX9].text, distance_parsecs))
 		{
-			newStarID = std::stoul(newStarIDAsString);
-		}
-		catch (const std::invalid_argument &e)
-		{
-			std::cerr << "Invalid argument: " << e.what() << std::endl;
-		}
-		catch (const std::out_of_range &e)
-		{
-			std::cerr << "Out of range: " << e.what() << std::endl;
+			skippedRows++;
+			continue;
 		}
 
 		// Get the Name of the Star from column 7 or others.
-		std::string newStarName = fields[NAME_INDEX6];
-
-		// If column 7's value is "", check columns 2 through 6 for a non-empty string to use as the name
-		if (newStarName == "\"\"")
+		// If column 7's value is blank, check columns 2 through 6 for a non-empty string to use as the name
+		std::string newStarName;
+		for (int i = NAME_INDEX6; i >= 2; --i)
 		{
-			for (int i = 6; i >= 2; --i)
+			if (!fields[i].text.empty())
 			{
-				if (fields[i] != "\"\"")
-				{
-					newStarName = fields[i];
-					// std::cout << "Found a non blank alternative name to use: " << newStarName << std::endl; // TOO VERBOSE
-					break; // Found a non-empty name, break the loop
-				}
+				newStarName = fieldToString(fields[i]);
+				break; // Found a non-empty name, break the loop
 			}
 		}
 
 		// Convert Spectral Type to RGB color using the provided function
-		std::string spectralType = fields[NAME_INDEX15]; // Assuming spectral type is in the 16th column
-		// std::cout << "Spectral Value from CSV: " << fields[NAME_INDEX15] << std::endl; // TOO VERBOSE
-
-		float starAppMagnitude = std::stof(fields[NAME_INDEX13]);
-
-		sf::Color rawStarColor = convertStellarTypeToColor(spectralType);
+		sf::Color rawStarColor = convertStellarTypeToColor(fields[NAME_INDEX15].text);
 		sf::Color adjStarColor = adjustStellarBrightness(rawStarColor, starAppMagnitude);
 
 		// Convert RA to radians (360 degrees = 24 hours)
@@ -115,30 +186,165 @@ std::vector<Star> LoadCSVData::loadStarsFromCsv(const std::string &csvFilePath,
 		// FACT: 6.28 radians in a full circle (2*PI)
 		// FACT: 360 degrees = 24 hours)
 
-		// float ra_rad = std::stof(fields[NAME_INDEX7]) * (2.0f * M_PI / 24.0f);
 		// do an 18 hour correction to rotate so we have N at upper display, S at bottom, and E+W associated to Right and left.
-		float ra_rad = (6.0f - std::stof(fields[NAME_INDEX7])) * (2.0f * M_PI / 24.0f);
-
-		// std::cout << "Input hours/mins value of " << fields[NAME_INDEX7] << " for star ID: " << fields[NAME_INDEX0] << " generates radian value of: " << ra_rad << std::endl; // TOO VERBOSE
-		//  Get the distance in parsecs
-		float distance_parsecs = std::stof(fields[NAME_INDEX9]);
+		float ra_rad = (6.0f - raHours) * (2.0f * M_PI / 24.0f);
 
 		// Calculate x and y based on scaling factor
-		float star_x = center_x + distance_parsecs * std::cos(ra_rad) * scaling_factor_x;
-		float star_y = center_y + distance_parsecs * std::sin(ra_rad) * scaling_factor_y;
+		float star_x = projection.centerX + distance_parsecs * std::cos(ra_rad) * projection.scaleX;
+		float star_y = projection.centerY + distance_parsecs * std::sin(ra_rad) * projection.scaleY;
 
 		// Create a Star object and add it to the vector
 		stars.emplace_back(newStarID, star_x, star_y, newStarName, adjStarColor);
+	}
+	return skippedRows;
+}
 
-		// Increment the loadedStars counter
-		loadedStars++;
+const char *LoadCSVData::findRowStart(const char *cursor, const char *end, bool insideQuotes)
+{
+	// Walk to the first line break outside quotes; the row after it starts here.
+	for (; cursor < end; ++cursor)
+	{
+		if (*cursor == '"')
+		{
+			insideQuotes = !insideQuotes;
+		}
+		else if (*cursor == '\n' && !insideQuotes)
+		{
+			return cursor + 1;
+		}
 	}
+	return end;
+}
 
-	csvFile.close();
-	return stars;
+const char *LoadCSVData::splitRow(const char *cursor, const char *end, CsvField *fields, size_t fieldCapacity, size_t &fieldCount)
+{
+	// RFC 4180 style: a field that starts with a quote runs to the matching closing quote, and may contain commas,
+	// line breaks and doubled quotes. Fields past fieldCapacity are scanned over but not stored.
+	fieldCount = 0;
+	while (true)
+	{
+		const char *fieldStart = cursor;
+		const char *fieldEnd;
+		bool hasEscapedQuotes = false;
+
+		if (cursor < end && *cursor == '"')
+		{
+			fieldStart = ++cursor;
+			while (cursor < end)
+			{
+				if (*cursor == '"')
+				{
+					if (cursor + 1 < end && cursor[1] == '"')
+					{
+						hasEscapedQuotes = true;
+						cursor += 2;
+						continue;
+					}
+					break;
+				}
+				++cursor;
+			}
+			fieldEnd = cursor;
+			if (cursor < end)
+			{
+				++cursor; // closing quote
+			}
+			// Anything between the closing quote and the next separator is malformed, drop it.
+			while (cursor < end && *cursor != ',' && *cursor != '\n' && *cursor != '\r')
+			{
+				++cursor;
+			}
+		}
+		else
+		{
+			while (cursor < end && *cursor != ',' && *cursor != '\n' && *cursor != '\r')
+			{
+				++cursor;
+			}
+			fieldEnd = cursor;
+		}
+
+		if (fieldCount < fieldCapacity)
+		{
+			fields[fieldCount].text = std::string_view(fieldStart, fieldEnd - fieldStart);
+			fields[fieldCount].hasEscapedQuotes = hasEscapedQuotes;
+		}
+		fieldCount++;
+
+		if (cursor < end && *cursor == ',')
+		{
+			++cursor;
+			continue;
+		}
+
+		// End of the row: step over the line break (\n or \r\n)
+		if (cursor < end && *cursor == '\r')
+		{
+			++cursor;
+		}
+		if (cursor < end && *cursor == '\n')
+		{
+			++cursor;
+		}
+		return cursor;
+	}
+}
+
+std::string LoadCSVData::fieldToString(const CsvField &field)
+{
+	if (!field.hasEscapedQuotes)
+	{
+		return std::string(field.text);
+	}
+
+	std::string result;
+	result.reserve(field.text.size());
+	for (size_t i = 0; i < field.text.size(); ++i)
+	{
+		result += field.text[i];
+		if (field.text[i] == '"')
+		{
+			++i; // "" stands for one quote
+		}
+	}
+	return result;
+}
+
+bool LoadCSVData::parseFloat(std::string_view text, float &value)
+{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+	std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+	return result.ec == std::errc();
+#else
+	// Standard libraries without floating point from_chars (Apple's libc++, older libstdc++). strtof wants a
+	// terminated string, so the field is copied out first. It also accepts leading spaces and '+', which from_chars
+	// does not, so those are turned away to read the catalog the same way on every platform.
+	char buffer[64];
+	if (text.empty() || text.size() >= sizeof(buffer) || text[0] == '+' || std::isspace(static_cast<unsigned char>(text[0])))
+	{
+		return false;
+	}
+	std::memcpy(buffer, text.data(), text.size());
+	buffer[text.size()] = '\0';
+	char *parsedEnd = nullptr;
+	errno = 0;
+	float parsed = std::strtof(buffer, &parsedEnd);
+	if (parsedEnd == buffer || errno == ERANGE)
+	{
+		return false;
+	}
+	value = parsed;
+	return true;
+#endif
+}
+
+bool LoadCSVData::parseUnsigned(std::string_view text, uint32_t &value)
+{
+	std::from_chars_result result = std::from_chars(text.data(), text.data() + text.size(), value);
+	return result.ec == std::errc();
 }
 
-sf::Color LoadCSVData::convertStellarTypeToColor(const std::string &stellarType)
+sf::Color LoadCSVData::convertStellarTypeToColor(std::string_view stellarType)
 {
 	// Check if the string is not empty
 	if (!stellarType.empty())
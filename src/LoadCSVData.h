@@ -3,19 +3,45 @@
 #define LOADCSVDATA_H
 
 #include "Star.h"
-#include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/System/Vector2.hpp>
 #include <SFML/Graphics/Color.hpp>
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include "LoadConfig.h"
+#include "ThreadPool.h"
 #include <vector>
 
 class LoadCSVData
 {
 public:
-	std::vector<Star> loadStarsFromCsv(const std::string &csvFilePath, sf::RenderWindow &window, const LoadConfig &config);
+	// mapSize is the pixel area the catalog is projected onto. Large files are parsed in chunks across threadPool;
+	// the stars come back in file order either way.
+	std::vector<Star> loadStarsFromCsv(const std::string &csvFilePath, const sf::Vector2u &mapSize, const LoadConfig &config, ThreadPool &threadPool);
 
 private:
-	static sf::Color convertStellarTypeToColor(const std::string &stellarType);
+	// Maps catalog RA/distance onto the screen
+	struct StarProjection
+	{
+		float centerX;
+		float centerY;
+		float scaleX;
+		float scaleY;
+	};
+	// One field of a CSV row, pointing into the mapped file. Surrounding quotes are already stripped.
+	struct CsvField
+	{
+		std::string_view text;
+		bool hasEscapedQuotes; // text still contains "" pairs that stand for a single quote
+	};
+
+	static int parseRows(const char *cursor, const char *end, const StarProjection &projection, size_t starLimit, std::vector<Star> &stars); // returns the number of rows skipped
+	static const char *findRowStart(const char *cursor, const char *end, bool insideQuotes); // first row that starts at or after cursor
+	static const char *splitRow(const char *cursor, const char *end, CsvField *fields, size_t fieldCapacity, size_t &fieldCount); // returns the start of the next row
+	static std::string fieldToString(const CsvField &field);
+	static bool parseFloat(std::string_view text, float &value);
+	static bool parseUnsigned(std::string_view text, uint32_t &value);
+	static sf::Color convertStellarTypeToColor(std::string_view stellarType);
 	static sf::Color adjustStellarBrightness(const sf::Color &originalColor, float brightnessFactor);
 };
 
@@ -1,5 +1,7 @@
 // LoadConfig.cpp
 #include "LoadConfig.h"
+#include "Probe.h"
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <nlohmann/json.hpp>
@@ -9,6 +11,18 @@ using json = nlohmann::json;
 namespace
 {
 	std::string configFilename = "./content/config.json"; // Hardcoded default "/config_path/filename.json"
+
+	// Reads an HTML-style "#RRGGBB" colour. Leaves colour alone and returns false for anything else.
+	bool parseColour(const std::string &text, sf::Color &colour)
+	{
+		if (text.size() != 7 || text[0] != '#' || text.find_first_not_of("0123456789abcdefABCDEF", 1) != std::string::npos)
+		{
+			return false;
+		}
+		unsigned long rgb = std::strtoul(text.c_str() + 1, nullptr, 16);
+		colour = sf::Color(static_cast<sf::Uint8>(rgb >> 16), static_cast<sf::Uint8>(rgb >> 8), static_cast<sf::Uint8>(rgb));
+		return true;
+	}
 }
 
 LoadConfig &LoadConfig::getInstance()
@@ -17,7 +31,13 @@ LoadConfig &LoadConfig::getInstance()
 	return instance;
 }
 
-LoadConfig::LoadConfig()
+LoadConfig::LoadConfig() : quadtreeMaxDepth(16),
+						   headless(false),
+						   simulationThreads(1),
+						   eventDrivenSimulation(false),
+						   spatialIndex("quadtree"),
+						   probeSize(1.0f),
+						   probeColours{sf::Color(173, 216, 230), sf::Color(173, 216, 230), sf::Color(173, 216, 230), sf::Color(90, 110, 120)}
 {
 	loadFromFile();
 }
@@ -62,6 +82,11 @@ int LoadConfig::getQuadTreeSearchSize() const
 	return quadtreeSearchSize;
 }
 
+int LoadConfig::getQuadTreeMaxDepth() const
+{
+	return quadtreeMaxDepth;
+}
+
 bool LoadConfig::getSummaryShowPerProbe() const
 {
 	return summaryShowPerProbe;
@@ -82,6 +107,41 @@ int LoadConfig::getProbeSearchRadiusPixels() const
 	return probeSearchRadiusPixels;
 }
 
+bool LoadConfig::getHeadless() const
+{
+	return headless;
+}
+
+unsigned int LoadConfig::getSimulationThreads() const
+{
+	return simulationThreads;
+}
+
+bool LoadConfig::getEventDrivenSimulation() const
+{
+	return eventDrivenSimulation;
+}
+
+const std::string &LoadConfig::getSpatialIndex() const
+{
+	return spatialIndex;
+}
+
+float LoadConfig::getProbeSize() const
+{
+	return probeSize;
+}
+
+const sf::Color &LoadConfig::getProbeColour(ProbeMode mode) const
+{
+	return probeColours[static_cast<size_t>(mode)];
+}
+
+void LoadConfig::setHeadless(bool headless)
+{
+	this->headless = headless;
+}
+
 void LoadConfig::loadFromFile()
 {
 	// std::string filename = configFilename;
@@ -176,6 +236,14 @@ void LoadConfig::loadFromFile()
 		{
 			std::cerr << "Error: Missing or invalid quadtreeSearchSize in the config file." << std::endl;
 		}
+		if (config.contains("quadtreeMaxDepth") && config["quadtreeMaxDepth"].is_number())
+		{
+			quadtreeMaxDepth = config["quadtreeMaxDepth"];
+		}
+		else
+		{
+			std::cerr << "Error: Missing or invalid quadtreeMaxDepth in the config file." << std::endl;
+		}
 
 		if (config.contains("summaryShowPerProbe") && config["summaryShowPerProbe"].is_string())
 		{
@@ -234,6 +302,100 @@ void LoadConfig::loadFromFile()
 		{
 			std::cerr << "Error: Missing or invalid probeSearchRadiusPixels in the config file." << std::endl;
 		}
+
+		if (config.contains("headless") && config["headless"].is_string())
+		{
+			std::string headlessMode = config["headless"];
+			if (headlessMode == "true")
+			{
+				headless = true;
+			}
+			else if (headlessMode == "false")
+			{
+				headless = false;
+			}
+			else
+			{
+				std::cerr << "Error: Invalid value for headless in the config file." << std::endl;
+			}
+		}
+		else
+		{
+			std::cerr << "Error: Missing or invalid headless in the config file." << std::endl;
+		}
+
+		if (config.contains("simulationThreads") && config["simulationThreads"].is_number_unsigned())
+		{
+			simulationThreads = config["simulationThreads"];
+		}
+		else
+		{
+			std::cerr << "Error: Missing or invalid simulationThreads in the config file." << std::endl;
+		}
+
+		if (config.contains("simulationEngine") && config["simulationEngine"].is_string())
+		{
+			std::string simulationEngine = config["simulationEngine"];
+			if (simulationEngine == "event")
+			{
+				eventDrivenSimulation = true;
+			}
+			else if (simulationEngine == "tick")
+			{
+				eventDrivenSimulation = false;
+			}
+			else
+			{
+				std::cerr << "Error: Invalid value for simulationEngine in the config file." << std::endl;
+			}
+		}
+		else
+		{
+			std::cerr << "Error: Missing or invalid simulationEngine in the config file." << std::endl;
+		}
+
+		if (config.contains("spatialIndex") && config["spatialIndex"].is_string())
+		{
+			std::string index = config["spatialIndex"];
+			if (index == "quadtree" || index == "grid" || index == "kdtree")
+			{
+				spatialIndex = index;
+			}
+			else
+			{
+				std::cerr << "Error: Invalid value for spatialIndex in the config file." << std::endl;
+			}
+		}
+		else
+		{
+			std::cerr << "Error: Missing or invalid spatialIndex in the config file." << std::endl;
+		}
+
+		if (config.contains("probeSize") && config["probeSize"].is_number())
+		{
+			probeSize = config["probeSize"];
+		}
+		else
+		{
+			std::cerr << "Error: Missing or invalid probeSize in the config file." << std::endl;
+		}
+
+		if (config.contains("probeColours") && config["probeColours"].is_object())
+		{
+			auto &colours = config["probeColours"];
+			const char *modeNames[4] = {"travel", "replicate", "seek", "shutdown"}; // in ProbeMode order
+			for (int mode = 0; mode < 4; ++mode)
+			{
+				if (!colours.contains(modeNames[mode]) || !colours[modeNames[mode]].is_string() || !parseColour(colours[modeNames[mode]], probeColours[mode]))
+				{
+					std::cerr << "Error: Missing or invalid probeColours " << modeNames[mode] << " in the config file." << std::endl;
+				}
+			}
+		}
+		else
+		{
+			std::cerr << "Error: Missing or invalid probeColours in the config file." << std::endl;
+		}
 	}
 	catch (json::parse_error &e)
 	{
@@ -2,8 +2,12 @@
 #ifndef LOADCONFIG_H
 #define LOADCONFIG_H
 
+#include <SFML/Graphics/Color.hpp>
+#include <cstdint>
 #include <string>
 
+enum class ProbeMode : uint8_t; // Probe.h
+
 class LoadConfig
 {
 public:
@@ -17,10 +21,18 @@ public:
 	int getLoadStarsLimit() const;
 	unsigned int getWorldSeed() const;
 	int getQuadTreeSearchSize() const;
+	int getQuadTreeMaxDepth() const;
 	bool getSummaryShowPerProbe() const;
 	bool getSummaryShowFooter() const;
 	int getprobeIndividualReplicationLimit() const;
 	int getProbeSearchRadiusPixels() const;
+	bool getHeadless() const;
+	unsigned int getSimulationThreads() const; // 0 means one per hardware core (see ThreadPool)
+	bool getEventDrivenSimulation() const;
+	const std::string &getSpatialIndex() const; // "quadtree", "grid" or "kdtree"
+	float getProbeSize() const; // side of the square drawn for each probe, in pixels
+	const sf::Color &getProbeColour(ProbeMode mode) const; // colour probes are drawn in while in that mode
+	void setHeadless(bool headless); // command line override of the config file value
 	void loadFromFile();
 
 private:
@@ -34,10 +46,17 @@ private:
 	int loadStarsLimit;
 	unsigned int worldSeed;
 	int quadtreeSearchSize;
+	int quadtreeMaxDepth;
 	bool summaryShowPerProbe;
 	bool summaryShowFooter;
 	int probeIndividualReplicationLimit;
 	int probeSearchRadiusPixels;
+	bool headless;
+	unsigned int simulationThreads;
+	bool eventDrivenSimulation;
+	std::string spatialIndex;
+	float probeSize;
+	sf::Color probeColours[4]; // indexed by ProbeMode
 
 	// void loadFromFile(const std::string &filename);
 	//  Declare copy constructor and assignment operator as private to prevent copying
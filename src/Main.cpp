@@ -1,9 +1,11 @@
 // Main.cpp
 #include "Game.h"
 #include "LoadConfig.h"
+#include "Simulation.h"
 #include "iostream"
+#include <string>
 
-int main()
+int main(int argc, char *argv[])
 {
 
 #if defined(_DEBUG)
@@ -14,7 +16,34 @@ int main()
 	// LoadConfig &myConfigInstance = LoadConfig::getInstance("./content/config.json"); // Dont supply parameter to global instance.
 
 	LoadConfig &myConfigInstance = LoadConfig::getInstance(); // Load config usage
+
+	// Command line switches override the "headless" value from config.json
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string argument = argv[i];
+		if (argument == "--headless")
+		{
+			myConfigInstance.setHeadless(true);
+		}
+		else if (argument == "--windowed")
+		{
+			myConfigInstance.setHeadless(false);
+		}
+		else
+		{
+			std::cerr << "Unknown argument: " << argument << std::endl;
+		}
+	}
+
+	if (myConfigInstance.getHeadless())
+	{
+		// No window or GL context, just the simulation and its summary.
+		Simulation mySimulation(myConfigInstance);
+		mySimulation.runHeadless();
+		return 0;
+	}
+
 	Game myGame(myConfigInstance);
 	myGame.run();
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,123 @@
+// MappedFile.cpp
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile(const std::string &filePath) : mappedData(nullptr),
+													  mappedSize(0),
+													  opened(false),
+													  fileHandle(INVALID_HANDLE_VALUE),
+													  mappingHandle(nullptr)
+{
+	fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize))
+	{
+		return;
+	}
+	opened = true;
+	mappedSize = static_cast<size_t>(fileSize.QuadPart);
+	if (mappedSize == 0)
+	{
+		return; // an empty file cannot be mapped, but it opened fine
+	}
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mappingHandle != nullptr)
+	{
+		mappedData = static_cast<const char *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (mappedData == nullptr)
+	{
+		opened = false;
+		mappedSize = 0;
+	}
+}
+
+MappedFile::~MappedFile()
+{
+	if (mappedData != nullptr)
+	{
+		UnmapViewOfFile(mappedData);
+	}
+	if (mappingHandle != nullptr)
+	{
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(fileHandle);
+	}
+}
+
+#else
+
+MappedFile::MappedFile(const std::string &filePath) : mappedData(nullptr),
+													  mappedSize(0),
+													  opened(false)
+{
+	int fileDescriptor = open(filePath.c_str(), O_RDONLY);
+	if (fileDescriptor < 0)
+	{
+		return;
+	}
+
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) == 0)
+	{
+		opened = true;
+		mappedSize = static_cast<size_t>(fileStatus.st_size);
+		if (mappedSize > 0)
+		{
+			void *mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+			if (mapping == MAP_FAILED)
+			{
+				opened = false;
+				mappedSize = 0;
+			}
+			else
+			{
+				mappedData = static_cast<const char *>(mapping);
+				madvise(mapping, mappedSize, MADV_SEQUENTIAL); // read front to back once
+			}
+		}
+	}
+	// The mapping stays valid after the descriptor is closed.
+	close(fileDescriptor);
+}
+
+MappedFile::~MappedFile()
+{
+	if (mappedData != nullptr)
+	{
+		munmap(const_cast<char *>(mappedData), mappedSize);
+	}
+}
+
+#endif
+
+bool MappedFile::isOpen() const
+{
+	return opened;
+}
+
+std::string_view MappedFile::getContents() const
+{
+	return mappedData != nullptr ? std::string_view(mappedData, mappedSize) : std::string_view();
+}
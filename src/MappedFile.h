@@ -0,0 +1,33 @@
+// MappedFile.h
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file. The contents can be read in place for as long as the object lives,
+// without copying them into a buffer first.
+class MappedFile
+{
+public:
+	explicit MappedFile(const std::string &filePath);
+	~MappedFile();
+
+	bool isOpen() const;
+	std::string_view getContents() const; // empty if the file could not be opened or is empty
+
+private:
+	const char *mappedData;
+	size_t mappedSize;
+	bool opened;
+#if defined(_WIN32)
+	void *fileHandle;
+	void *mappingHandle;
+#endif
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile &operator=(const MappedFile &) = delete;
+};
+
+#endif // MAPPEDFILE_H
@@ -1,25 +1,28 @@
 // Probe.cpp
 #include "Probe.h"
 #include "Star.h"
-#include <algorithm> // For std::find
-#include <cmath>	 // For std::sqrt
+#include <algorithm> // For std::min
+#include <cmath>	 // For std::cos, std::sin
 #include <iostream>
 #include <limits>
 #include <random>
 #include "LoadConfig.h"
+#include "ProbeSystem.h"
 
 // Constructor (these are things that get set on a new instance)
-// Probe::Probe(const std::string &probeName, float initialX, float initialY, float speed, const std::vector<Star> &galaxyVector, GalaxyQuadTree &quadTree)
-Probe::Probe(const std::string &probeName, float initialX, float initialY, float speed, GalaxyQuadTree &quadTree) : probeName(probeName),
-																													x(initialX),
-																													y(initialY),
-																													speed(speed),
-																													mode(ProbeMode::Seek),
-																													quadTree(quadTree),
-																													newBorn(true),
-																													totalDistanceTraveled(0.0f),
-																													replicationCount(0),
-																													myConfigInstance(&LoadConfig::getInstance())
+// Position, speed and mode are set by ProbeSystem::spawn, which owns them.
+Probe::Probe(const std::string &probeName, ProbeSystem &system, uint32_t slot, SpatialIndex &spatialIndex) : probeName(probeName),
+																											 system(&system),
+																											 slot(slot),
+																											 targetStar(std::numeric_limits<uint32_t>::max()),
+																											 targetStarIndex(SpatialIndex::InvalidIndex),
+																											 holdsTargetClaim(false),
+																											 spatialIndex(spatialIndex),
+																											 currentQuadTreeNode(0),
+																											 newBorn(true),
+																											 totalDistanceTraveled(0.0f),
+																											 replicationCount(0),
+																											 myConfigInstance(&LoadConfig::getInstance())
 
 // visitedStarCount(0)
 {
@@ -30,26 +33,18 @@ std::string Probe::visitedStarSystemsToString() const
 {
 	std::string result;
 
-	for (const auto &visitedSystem : visitedStarSystems)
-	{
-		result += "Star ID: " + std::to_string(visitedSystem.starID) + result += " Coordinates: (" + std::to_string(visitedSystem.coordinates.x) + ", " + std::to_string(visitedSystem.coordinates.y) + ")\n";
-		// result += "Visited by Probe: " + (visitedSystem.visitedByProbe ? "Yes" : "No") + "\n\n";
-	}
+	// result += "Visited by Probe: " + (visitedSystem.visitedByProbe ? "Yes" : "No") + "\n\n";
+	visitedStarSystems.forEach([&result](const VisitedStarSystem &visitedSystem)
+							   { result += "Star ID: " + std::to_string(visitedSystem.starID) + " Coordinates: (" + std::to_string(visitedSystem.coordinates.x) + ", " + std::to_string(visitedSystem.coordinates.y) + ")\n"; });
 
 	return result;
 }
 
-// Destructor
-Probe::~Probe()
-{
-	// Cleanup if needed
-}
-
 // Setters
 void Probe::setCoordinates(float x, float y)
 {
-	this->x = x;
-	this->y = y;
+	system->positionX[slot] = x;
+	system->positionY[slot] = y;
 }
 
 void Probe::setTargetStar(uint32_t &targetStar)
@@ -57,27 +52,52 @@ void Probe::setTargetStar(uint32_t &targetStar)
 	this->targetStar = targetStar;
 }
 
+void Probe::setTargetStarIndex(uint32_t starIndex)
+{
+	targetStarIndex = starIndex;
+}
+
+void Probe::seedRandomGenerator(uint32_t seed)
+{
+	randomGenerator.seed(seed);
+}
+
 void Probe::setSpeed(float speed)
 {
-	this->speed = speed;
+	system->speed[slot] = speed;
 }
 
 void Probe::setMode(ProbeMode mode)
 {
-	this->mode = mode;
+	if (mode == ProbeMode::Shutdown && holdsTargetClaim)
+	{
+		// Give the star back so another probe can pick it up.
+		spatialIndex.releaseStar(targetStarIndex);
+		holdsTargetClaim = false;
+	}
+	system->mode[slot] = mode;
+	if (mode == ProbeMode::Travel)
+	{
+		// Work out the whole leg now, from the current position, target and speed.
+		system->beginLeg(slot);
+	}
 	// std::cout << "setMode has been invoked\n";
 }
 
 void Probe::setTargetCoordinates(float newX, float newY)
 {
-	targetX = newX;
-	targetY = newY;
+	system->targetX[slot] = newX;
+	system->targetY[slot] = newY;
 }
 
 void Probe::addVisitedStarSystem(const uint32_t &starID, const sf::Vector2f &coordinates, bool visitedByProbe)
 {
-	VisitedStarSystem visitedSystem = {starID, coordinates, visitedByProbe};
-	visitedStarSystems.push_back(visitedSystem);
+	visitedStarSystems.add(starID, coordinates, visitedByProbe);
+}
+
+void Probe::inheritVisitedStarSystems(Probe &parent)
+{
+	visitedStarSystems = parent.visitedStarSystems.inherit();
 }
 
 // Getters
@@ -88,17 +108,17 @@ std::string Probe::getProbeName() const
 
 float Probe::getX() const
 {
-	return x;
+	return system->positionX[slot];
 }
 
 float Probe::getY() const
 {
-	return y;
+	return system->positionY[slot];
 }
 
 float Probe::getSpeed() const
 {
-	return speed;
+	return system->speed[slot];
 }
 
 uint32_t Probe::getTargetStar() const
@@ -106,73 +126,99 @@ uint32_t Probe::getTargetStar() const
 	return targetStar;
 }
 
+uint32_t Probe::getTargetStarIndex() const
+{
+	return targetStarIndex;
+}
+
 ProbeMode Probe::getMode() const
 {
-	return mode;
+	return system->mode[slot];
 }
 
-void Probe::move()
+ProbeIntent Probe::planStep() const
 {
-	if (mode == ProbeMode::Travel)
+	ProbeIntent intent = {false, SpatialIndex::InvalidIndex};
+
+	// Only two things search this tick: a seeking probe (unless it is a newborn about to fly off to a random point),
+	// and a replicating probe picking its next target so the child can be pointed elsewhere.
+	ProbeMode mode = getMode();
+	bool seeking = mode == ProbeMode::Seek && !(isNewBorn() && !visitedStarSystems.empty());
+	bool replicating = mode == ProbeMode::Replicate && getReplicationCount() < myConfigInstance->getprobeIndividualReplicationLimit();
+	if (seeking || replicating)
 	{
-		// Calculate the direction from current position to the target position
-		float deltaX = targetX - x;
-		float deltaY = targetY - y;
-		float distanceToTarget = sqrt(deltaX * deltaX + deltaY * deltaY);
-
-		// Calculate the movement step size based on speed
-		float stepSize = speed; // Adjust this based on your needs
+		intent.hasPlannedTarget = true;
+		intent.plannedTarget = findNearestUnvisitedStarInQuadTree();
+	}
+	return intent;
+}
 
-		if (distanceToTarget <= stepSize)
-		{
-			// If the distance to the target is smaller than or equal to the step size, move directly to the target position
-			setCoordinates(targetX, targetY);
-			// Probe has arrived!
+uint32_t Probe::resolveNextTarget(const ProbeIntent &intent) const
+{
+	// Claims and arrivals only take stars out of the available set, so a planned star that is still available is still the
+	// nearest. (A claim released by a probe shutting down can be missed until the next search, the same for any thread count.)
+	if (intent.hasPlannedTarget && (intent.plannedTarget == SpatialIndex::InvalidIndex || isStarAvailable(intent.plannedTarget)))
+	{
+		return intent.plannedTarget;
+	}
+	return findNearestUnvisitedStarInQuadTree();
+}
 
-			// Update distance traveled
-			totalDistanceTraveled += distanceToTarget;
-			// update probe memory with newly arrived star, before finding next target.
-			addVisitedStarSystem(this->getTargetStar(), sf::Vector2f(this->getX(), this->getY()), true);
+void Probe::arrive()
+{
+	// Move directly to the target position (the event-driven engine does not step positions in between).
+	setCoordinates(system->targetX[slot], system->targetY[slot]);
+	// Probe has arrived!
+
+	// Update distance traveled with the whole leg
+	totalDistanceTraveled += system->legDistance[slot];
+	// update probe memory with newly arrived star, before finding next target.
+	addVisitedStarSystem(this->getTargetStar(), sf::Vector2f(this->getX(), this->getY()), true);
+	// Newborns fly to a random point near their parent rather than to a star, so there may be nothing to mark.
+	if (targetStarIndex != SpatialIndex::InvalidIndex)
+	{
+		spatialIndex.markStarExplored(targetStarIndex); // Claimed -> Explored
+		holdsTargetClaim = false;
+	}
 
-			// TODO - need to set this probes current quadtree location so that we can use it as a search parameter from game class, so we can establish next valid target and stop child probe going there. phew.
-			// Determine the current quadtree node based on the probe's position
-			// ...
+	// Remember the leaf the probe is now in, so its next search starts there instead of at the root.
+	currentQuadTreeNode = spatialIndex.locate(sf::Vector2f(getX(), getY()), currentQuadTreeNode);
 
-			// Update currentQuadTreeNode with the new node
-			// currentQuadTreeNode = // ... the new node
+	if (this->isNewBorn())
+	{
+		this->setNewBorn(false);
+		setMode(ProbeMode::Seek);
+	}
+	else
+	{
+		// if (this->getReplicationCount() >= config.getprobeIndividualReplicationLimit()){
+		// int globalSetting = myConfigInstance.getprobeIndividualReplicationLimit();
+		// int globalSetting = LoadConfig::getInstance().getprobeIndividualReplicationLimit();
 
-			if (this->isNewBorn())
-			{
-				this->setNewBorn(false);
-				setMode(ProbeMode::Seek);
-			}
-			else
-			{
-				// if (this->getReplicationCount() >= config.getprobeIndividualReplicationLimit()){
-				// int globalSetting = myConfigInstance.getprobeIndividualReplicationLimit();
-				// int globalSetting = LoadConfig::getInstance().getprobeIndividualReplicationLimit();
-
-				if (this->getReplicationCount() >= myConfigInstance->getprobeIndividualReplicationLimit())
-				{
-					// do what we like here, keep seeking if cant replicate.
-					// setMode(ProbeMode::Seek);
-					setMode(ProbeMode::Shutdown);
-				}
-				else
-				{
-					// Set mode to Seek (to have one probe just move around) or replicate to start spreading.(ONLY IF NOT NEWBORN)
-					setMode(ProbeMode::Replicate);
-				}
-			}
+		if (this->getReplicationCount() >= myConfigInstance->getprobeIndividualReplicationLimit())
+		{
+			// do what we like here, keep seeking if cant replicate.
+			// setMode(ProbeMode::Seek);
+			setMode(ProbeMode::Shutdown);
 		}
 		else
 		{
-			// Calculate the normalized direction vector
-			float directionX = deltaX / distanceToTarget;
-			float directionY = deltaY / distanceToTarget;
+			// Set mode to Seek (to have one probe just move around) or replicate to start spreading.(ONLY IF NOT NEWBORN)
+			setMode(ProbeMode::Replicate);
+		}
+	}
+}
 
-			// Move towards the target position by the step size in the direction of the target
-			setCoordinates(x + directionX * stepSize, y + directionY * stepSize);
+void Probe::move(const ProbeIntent &intent)
+{
+	ProbeMode mode = getMode();
+	if (mode == ProbeMode::Travel)
+	{
+		// The simulation moves all travelling probes at once with ProbeSystem::advanceTravellingProbes; this is the same step for one probe.
+		system->advanceTravellingProbes(slot, slot + 1);
+		if (system->hasArrived(slot))
+		{
+			arrive();
 		}
 	}
 	else if (mode == ProbeMode::Replicate)
@@ -189,10 +235,8 @@ void Probe::move()
 			// Define an offset range from the parent's position
 			std::uniform_real_distribution<float> disAngle(0.0f, 2.0f * 3.14159f); // Angle range for full circle
 			std::uniform_real_distribution<float> disDistance(30.0f, 60.0f);	   // Distance range from 50 to 100 pixels
-			std::random_device rd;
-			std::mt19937 gen(rd());
-			float randomAngle = disAngle(gen);		 // Random angle in radians
-			float randomDistance = disDistance(gen); // Random distance
+			float randomAngle = disAngle(randomGenerator);		 // Random angle in radians
+			float randomDistance = disDistance(randomGenerator); // Random distance
 
 			// Calculate new coordinates based on random angle and distance from the parent's position
 			float offsetX = randomDistance * std::cos(randomAngle);
@@ -201,23 +245,31 @@ void Probe::move()
 			// Update target coordinates within a range from the parent's position
 			setTargetCoordinates(this->getX() + offsetX, this->getY() + offsetY);
 
-			setMode(ProbeMode::Travel);
 			setSpeed(10);
+			setMode(ProbeMode::Travel);
 			return;
 		}
 		else
 		{
 			// const Star *nearestStar = findNearestUnvisitedStarByRadius();
 			// setup a pointer (called nearestStar) to a star object returned by the finding method.
-			const Star *nearestStar = findNearestUnvisitedStarInQuadTree(quadTree.getRootNode(), myConfigInstance->getProbeSearchRadiusPixels());
+			uint32_t nearestStarIndex = resolveNextTarget(intent);
+			// Claim the star so no other probe sets off for it. If someone beat us to it, look again.
+			while (nearestStarIndex != SpatialIndex::InvalidIndex && !spatialIndex.claimStar(nearestStarIndex))
+			{
+				nearestStarIndex = findNearestUnvisitedStarInQuadTree();
+			}
 
-			if (nearestStar)
+			if (nearestStarIndex != SpatialIndex::InvalidIndex)
 			{
+				const Star *nearestStar = &spatialIndex.getStar(nearestStarIndex);
 				this->setTargetCoordinates(nearestStar->getX(), nearestStar->getY());
 				uint32_t newTarget = (nearestStar->getID()); // NOTE:have to create intermediate variable for star ID to then pass into setTargetStar. Complains if done directly.
 				this->setTargetStar(newTarget);
-				setMode(ProbeMode::Travel);
+				this->setTargetStarIndex(nearestStarIndex);
+				holdsTargetClaim = true;
 				this->setSpeed(10);
+				setMode(ProbeMode::Travel);
 			}
 			else
 			{
@@ -269,11 +321,16 @@ int Probe::getReplicationCount() const
 }
 */
 
-const std::vector<VisitedStarSystem> &Probe::getVisitedStarSystems() const
+const VisitedStarHistory &Probe::getVisitedStarSystems() const
 {
 	return visitedStarSystems;
 }
 
+bool Probe::hasVisitedStarSystem(uint32_t starID) const
+{
+	return visitedStarSystems.contains(starID);
+}
+
 sf::Color Probe::getTrailColor() const
 {
 	return trailColor; // Return the trailColor
@@ -314,51 +371,19 @@ void Probe::setRandomTrailColor()
 	trailColor = sf::Color(red, green, blue);
 }
 
-const Star *Probe::findNearestUnvisitedStarInQuadTree(const GalaxyQuadTreeNode *node, float searchRadius) const
+uint32_t Probe::findNearestUnvisitedStarInQuadTree() const
 {
-	if (node == nullptr)
-	{
-		return nullptr;
-	}
-
-	const Star *nearestStar = nullptr;
-	float minDistance = std::numeric_limits<float>::max();
-
-	sf::FloatRect searchArea(x - searchRadius, y - searchRadius, searchRadius * 2, searchRadius * 2);
-	if (node->boundary.intersects(searchArea))
-	{
-		for (const auto &star : node->stars)
-		{
-			if (!star.getIsExplored() && std::find_if(visitedStarSystems.begin(), visitedStarSystems.end(), [&star](const VisitedStarSystem &visitedSystem)
-													  { return visitedSystem.starID == star.getID(); }) == visitedStarSystems.end())
-			{
+	// probeSearchRadiusPixels of 0 (or less) means search the whole map.
+	float searchRadius = myConfigInstance->getProbeSearchRadiusPixels() > 0 ? myConfigInstance->getProbeSearchRadiusPixels() : std::numeric_limits<float>::infinity();
 
-				float distance = std::sqrt(std::pow(star.getX() - x, 2) + std::pow(star.getY() - y, 2));
-				if (distance <= searchRadius && distance < minDistance)
-				{
-					minDistance = distance;
-					nearestStar = &star;
-				}
-			}
-		}
-
-		if (!node->isLeaf)
-		{
-			for (int i = 0; i < 4; ++i)
-			{
-				const Star *childNearestStar = findNearestUnvisitedStarInQuadTree(node->getChild(i), searchRadius);
-				if (childNearestStar)
-				{
-					float childDistance = std::sqrt(std::pow(childNearestStar->getX() - x, 2) + std::pow(childNearestStar->getY() - y, 2));
-					if (childDistance < minDistance)
-					{
-						minDistance = childDistance;
-						nearestStar = childNearestStar;
-					}
-				}
-			}
-		}
-	}
+	return spatialIndex.findNearestAvailable(
+		sf::Vector2f(getX(), getY()), [this](uint32_t starIndex)
+		{ return isStarAvailable(starIndex); },
+		searchRadius, currentQuadTreeNode);
+}
 
-	return nearestStar;
-}
\ No newline at end of file
+bool Probe::isStarAvailable(uint32_t starIndex) const
+{
+	const Star &star = spatialIndex.getStar(starIndex);
+	return star.getIsAvailable() && !hasVisitedStarSystem(star.getID());
+}
@@ -5,12 +5,17 @@
 #include "Star.h"
 #include <SFML/Graphics.hpp>	   // Include SFML for colors
 #include <SFML/System/Vector2.hpp> // Include SFML for Vector2f
+#include <cstdint>
+#include <random>
 #include <string>
 #include <vector>
-#include "GalaxyQuadTree.h"
+#include "SpatialIndex.h"
 #include "LoadConfig.h"
+#include "VisitedStarHistory.h"
 
-enum class ProbeMode
+class ProbeSystem;
+
+enum class ProbeMode : uint8_t
 {
 	Travel,
 	Replicate,
@@ -18,21 +23,18 @@ enum class ProbeMode
 	Shutdown
 };
 
-struct VisitedStarSystem // Probes own private memory of visited systems.
+// What a probe worked out during the parallel planning phase of a tick, against the star state at the start of the tick.
+struct ProbeIntent
 {
-	// std::string systemName;
-	uint32_t starID;
-	sf::Vector2f coordinates; // Coordinates of the star system
-	bool visitedByProbe;	  // Indicator to differentiate direct visitation by probe (true) or parent (false)
+	bool hasPlannedTarget;	 // true if the probe needed a target search this tick
+	uint32_t plannedTarget; // the search result (SpatialIndex::InvalidIndex if nothing was found)
 };
 
 // The constructor for any class .h file is defined in the class under the "public" section. In C++, the constructor is a special member function with the same name as the class, and it is used for initializing the object's state when an instance of the class is created.
 class Probe
 {
 public:
-	Probe(const std::string &probeName, float initialX, float initialY, float speed, GalaxyQuadTree &quadTree); // Probes require access to the same shared galaxyVector object to update resources there.
-	// Destructor
-	~Probe();
+	Probe(const std::string &probeName, ProbeSystem &system, uint32_t slot, SpatialIndex &spatialIndex); // Created by ProbeSystem::spawn. Probes require access to the same shared galaxyVector object to update resources there.
 
 	std::string visitedStarSystemsToString() const;
 
@@ -43,9 +45,12 @@ public:
 	void setTargetCoordinates(float newX, float newY);
 	void setNewBorn(bool status);
 	void addVisitedStarSystem(const uint32_t &starID, const sf::Vector2f &coordinates, bool visitedByProbe);
+	void inheritVisitedStarSystems(Probe &parent); // share the parent's history so far (O(1), no copying)
 	void setRandomTrailColor();
 	void setBlackTrailColor();
 	void setTargetStar(uint32_t &setTargetStar);
+	void setTargetStarIndex(uint32_t starIndex);
+	void seedRandomGenerator(uint32_t seed); // per-probe generator, so runs are repeatable for a given worldSeed
 
 	// Getters
 	std::string getProbeName() const;
@@ -53,38 +58,43 @@ public:
 	float getY() const;
 	float getSpeed() const;
 	uint32_t getTargetStar() const;
+	uint32_t getTargetStarIndex() const;
 	ProbeMode getMode() const;
 	bool isNewBorn() const;
 	float getTotalDistanceTraveled() const;
 	int getReplicationCount() const;
 	// int getVisitedStarCount() const;
-	const std::vector<VisitedStarSystem> &getVisitedStarSystems() const;
+	const VisitedStarHistory &getVisitedStarSystems() const;
+	bool hasVisitedStarSystem(uint32_t starID) const; // inherited history included
 	sf::Color getTrailColor() const; // Declaration of getTrailColor method
 
 	// Other methods
-	void move(); // Example method representing movement logic
-	const Star *findNearestUnvisitedStarInQuadTree(const GalaxyQuadTreeNode *node, float searchRadius) const;
-	const GalaxyQuadTreeNode *getCurrentQuadTreeNode() const
+	void move(const ProbeIntent &intent = ProbeIntent{false, SpatialIndex::InvalidIndex}); // Example method representing movement logic
+	void arrive();												   // reached the target: record it and pick the next mode
+	ProbeIntent planStep() const;								   // read only, safe to run on worker threads while no probe is moving
+	uint32_t resolveNextTarget(const ProbeIntent &intent) const; // planned target if it is still free, otherwise a fresh search
+	uint32_t findNearestUnvisitedStarInQuadTree() const;		   // returns an index into the star table, or SpatialIndex::InvalidIndex
+	bool isStarAvailable(uint32_t starIndex) const;			   // not claimed or explored by anyone and not in this probe's history
+	uint32_t getCurrentQuadTreeNode() const
 	{
 		return currentQuadTreeNode;
 	}
 
 private:
 	std::string probeName;
-	float x;
-	float y;
-	float targetX;
-	float targetY;
-	uint32_t targetStar;
-	float speed;
-	ProbeMode mode;
-	std::vector<VisitedStarSystem> visitedStarSystems; // a vector named visitedStarSystems that contains elements of type VisitedStarSystem
-	GalaxyQuadTree &quadTree;
-	const GalaxyQuadTreeNode *currentQuadTreeNode;
+	ProbeSystem *system; // owner of this probe's hot state (position, target, speed, mode)
+	uint32_t slot;		 // index of this probe in the ProbeSystem arrays
+	uint32_t targetStar;	   // catalog ID of the target star
+	uint32_t targetStarIndex; // index of the target star in the shared star table
+	bool holdsTargetClaim;	   // true from claiming the target star until arriving at it
+	VisitedStarHistory visitedStarSystems; // ordered trail of visited systems, shared with ancestors and descendants
+	SpatialIndex &spatialIndex;
+	uint32_t currentQuadTreeNode; // spatial index hint for where the probe last arrived (with the quadtree, the leaf it is in), where its searches start
 	bool newBorn;
 	float totalDistanceTraveled;
 	int replicationCount;
 	sf::Color trailColor; // Declaration of trailColor within the class
+	std::minstd_rand randomGenerator;
 	LoadConfig *myConfigInstance;
 };
 
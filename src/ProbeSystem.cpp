@@ -0,0 +1,154 @@
+// ProbeSystem.cpp
+#include "ProbeSystem.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace
+{
+	// Bitwise select, so picking the new or old position is arithmetic rather than a branch the vectoriser gives up on
+	inline float selectBits(uint32_t mask, float ifSet, float ifClear)
+	{
+		uint32_t setBits;
+		uint32_t clearBits;
+		std::memcpy(&setBits, &ifSet, sizeof(float));
+		std::memcpy(&clearBits, &ifClear, sizeof(float));
+		uint32_t bits = (setBits & mask) | (clearBits & ~mask);
+		float result;
+		std::memcpy(&result, &bits, sizeof(float));
+		return result;
+	}
+
+	// Branch-free body over the arrays: every probe interpolates a position and a mask built from its mode picks
+	// whether it is applied. legTicks is at least 1 in every slot, so the divide is safe for idle probes too.
+	// Position is target + (start - target) * ticks left / leg ticks, so it lands exactly on the target on the
+	// arrival tick. The leg's sqrt is taken once in beginLeg, so this loop makes no libm calls. The arrays never
+	// overlap, and the restrict parameters spare the vectoriser the runtime alias checks (uint8_t may alias
+	// anything) it would otherwise give up on. GCC vectorises it at -O3 (Release); the CMake default Debug build
+	// and GCC's -O2 cost model leave it scalar.
+	void advanceKernel(size_t begin, size_t end, uint32_t tick, float *__restrict x, float *__restrict y, const float *__restrict fromX, const float *__restrict fromY, const float *__restrict tx, const float *__restrict ty, const uint32_t *__restrict ticks, const uint32_t *__restrict arrival, const ProbeMode *__restrict probeMode, uint8_t *__restrict arrivedFlags)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			uint32_t travelling = 0u - static_cast<uint32_t>(probeMode[i] == ProbeMode::Travel); // all ones or zero
+			uint32_t ticksLeft = arrival[i] - tick;
+			float remaining = static_cast<float>(ticksLeft) / static_cast<float>(ticks[i]);
+			float newX = tx[i] + (fromX[i] - tx[i]) * remaining;
+			float newY = ty[i] + (fromY[i] - ty[i]) * remaining;
+			x[i] = selectBits(travelling, newX, x[i]);
+			y[i] = selectBits(travelling, newY, y[i]);
+			arrivedFlags[i] = static_cast<uint8_t>(travelling & (ticksLeft == 0));
+		}
+	}
+}
+
+ProbeSystem::ProbeSystem() : currentTick(0)
+{
+}
+
+Probe &ProbeSystem::spawn(const std::string &probeName, float initialX, float initialY, float initialSpeed, SpatialIndex &spatialIndex)
+{
+	uint32_t slot = static_cast<uint32_t>(probes.size());
+	positionX.push_back(initialX);
+	positionY.push_back(initialY);
+	departX.push_back(initialX);
+	departY.push_back(initialY);
+	targetX.push_back(initialX);
+	targetY.push_back(initialY);
+	speed.push_back(initialSpeed);
+	legDistance.push_back(0.0f);
+	legTicks.push_back(1);
+	arrivalTick.push_back(currentTick);
+	mode.push_back(ProbeMode::Seek);
+	arrived.push_back(0);
+	static_assert(std::is_nothrow_move_constructible<Probe>::value, "growing probes must move their histories, not copy them");
+	probes.emplace_back(probeName, *this, slot, spatialIndex);
+	return probes.back();
+}
+
+size_t ProbeSystem::size() const
+{
+	return probes.size();
+}
+
+Probe &ProbeSystem::operator[](size_t slot)
+{
+	return probes[slot];
+}
+
+const Probe &ProbeSystem::operator[](size_t slot) const
+{
+	return probes[slot];
+}
+
+std::vector<Probe>::const_iterator ProbeSystem::begin() const
+{
+	return probes.begin();
+}
+
+std::vector<Probe>::const_iterator ProbeSystem::end() const
+{
+	return probes.end();
+}
+
+void ProbeSystem::setCurrentTick(uint32_t tick)
+{
+	currentTick = tick;
+}
+
+uint32_t ProbeSystem::getCurrentTick() const
+{
+	return currentTick;
+}
+
+uint32_t ProbeSystem::getArrivalTick(size_t slot) const
+{
+	return arrivalTick[slot];
+}
+
+float ProbeSystem::getX(size_t slot) const
+{
+	return positionX[slot];
+}
+
+float ProbeSystem::getY(size_t slot) const
+{
+	return positionY[slot];
+}
+
+ProbeMode ProbeSystem::getMode(size_t slot) const
+{
+	return mode[slot];
+}
+
+void ProbeSystem::beginLeg(size_t slot)
+{
+	float deltaX = targetX[slot] - positionX[slot];
+	float deltaY = targetY[slot] - positionY[slot];
+	float distance = std::sqrt(deltaX * deltaX + deltaY * deltaY);
+
+	departX[slot] = positionX[slot];
+	departY[slot] = positionY[slot];
+	legDistance[slot] = distance;
+
+	// A leg that fits inside one step still takes a tick. A probe with no speed never gets anywhere.
+	uint32_t ticks = 1;
+	if (distance > speed[slot])
+	{
+		float exactTicks = speed[slot] > 0.0f ? std::ceil(distance / speed[slot]) : std::numeric_limits<float>::infinity();
+		ticks = exactTicks < static_cast<float>(std::numeric_limits<uint32_t>::max() - currentTick) ? static_cast<uint32_t>(exactTicks) : std::numeric_limits<uint32_t>::max() - currentTick;
+	}
+	legTicks[slot] = ticks;
+	arrivalTick[slot] = currentTick + ticks;
+}
+
+void ProbeSystem::advanceTravellingProbes(size_t begin, size_t end)
+{
+	advanceKernel(begin, end, currentTick, positionX.data(), positionY.data(), departX.data(), departY.data(), targetX.data(), targetY.data(), legTicks.data(), arrivalTick.data(), mode.data(), arrived.data());
+}
+
+bool ProbeSystem::hasArrived(size_t slot) const
+{
+	return arrived[slot] != 0;
+}
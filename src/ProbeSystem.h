@@ -0,0 +1,65 @@
+// ProbeSystem.h
+#ifndef PROBESYSTEM_H
+#define PROBESYSTEM_H
+
+#include "Probe.h"
+#include "SpatialIndex.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Owns every probe. The state touched every tick (position, target, speed, mode) is kept in parallel arrays indexed
+// by probe slot, so the travel kernel streams through tightly packed floats. Names, histories, colours and the
+// rest of the per-probe bookkeeping stay in the Probe objects, which read and write their hot state through here.
+//
+// A travel leg is worked out once, when the probe departs: it takes max(1, ceil(distance / speed)) ticks and the
+// probe's position part way along is interpolated from the tick number. Both the tick-by-tick and the event-driven
+// simulation engines use this, so they agree exactly on when every probe arrives.
+class ProbeSystem
+{
+public:
+	ProbeSystem();
+
+	Probe &spawn(const std::string &probeName, float initialX, float initialY, float speed, SpatialIndex &spatialIndex); // reference is only valid until the next spawn
+	size_t size() const;
+	Probe &operator[](size_t slot);
+	const Probe &operator[](size_t slot) const;
+	std::vector<Probe>::const_iterator begin() const;
+	std::vector<Probe>::const_iterator end() const;
+
+	void setCurrentTick(uint32_t tick); // legs that start from now on depart at this tick
+	uint32_t getCurrentTick() const;
+	uint32_t getArrivalTick(size_t slot) const; // tick the current leg ends on, for a probe in Travel mode
+	float getX(size_t slot) const; // straight from the arrays, for walking every probe without touching the Probe objects
+	float getY(size_t slot) const;
+	ProbeMode getMode(size_t slot) const;
+
+	// Travel kernel. Puts every probe in slots [begin, end) that is in Travel mode at its position for the current
+	// tick, and flags the ones whose leg ends on this tick. Arrivals are left for Probe::arrive, which touches shared
+	// star state. Slots are independent, so ranges can run on different threads.
+	void advanceTravellingProbes(size_t begin, size_t end);
+	bool hasArrived(size_t slot) const; // result of the last advanceTravellingProbes covering this slot
+
+private:
+	friend class Probe;
+
+	void beginLeg(size_t slot); // called by Probe when it switches to Travel mode
+
+	uint32_t currentTick;
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> departX; // where the current leg started
+	std::vector<float> departY;
+	std::vector<float> targetX;
+	std::vector<float> targetY;
+	std::vector<float> speed;
+	std::vector<float> legDistance;
+	std::vector<uint32_t> legTicks;
+	std::vector<uint32_t> arrivalTick;
+	std::vector<ProbeMode> mode;
+	std::vector<uint8_t> arrived;
+	std::vector<Probe> probes; // cold per-probe data, same slot order as the arrays above
+};
+
+#endif // PROBESYSTEM_H
@@ -2,14 +2,27 @@
 #include "RenderSystem.h"
 #include "Probe.h"
 #include "GalaxyQuadTreeNode.h"
+#include <algorithm>
 #include <iostream>
 
-RenderSystem::RenderSystem(sf::RenderWindow &window) : renderWindow(window),
-													   showTextLabelsStars(false),
-													   showTextLabelsProbes(false),
-													   showProbeTrails(false),
-													   showDebugGraphics(false)
+RenderSystem::RenderSystem(sf::RenderWindow &window, const LoadConfig &config) : renderWindow(window),
+																				  probeVertices(sf::Quads),
+																				  probeSize(config.getProbeSize()),
+																				  trailBuffer(sf::Lines, sf::VertexBuffer::Dynamic),
+																				  trailBufferedCount(0),
+																				  useTrailBuffer(sf::VertexBuffer::isAvailable()),
+																				  starLabels(font, 14, sf::Vector2f(10.0f, 10.0f)),
+																				  probeLabels(font, 10, sf::Vector2f(-10.0f, -10.0f)),
+																				  showTextLabelsStars(false),
+																				  showTextLabelsProbes(false),
+																				  showProbeTrails(false),
+																				  showDebugGraphics(false)
 {
+	for (int mode = 0; mode < 4; ++mode)
+	{
+		probeColours[mode] = config.getProbeColour(static_cast<ProbeMode>(mode));
+	}
+
 	// Initialize RenderSystem, if needed
 	// TODO - load this from the config object somehow.
 	if (!font.loadFromFile("./content/Frontier.ttf"))
@@ -43,113 +56,160 @@ void RenderSystem::toggleDebugGraphics()
 	showDebugGraphics = !showDebugGraphics; // Toggle the flag
 }
 
-// Initialization - Render stars onto a texture
-void RenderSystem::initializeStarsTexture(const std::vector<Star> &stars)
+void RenderSystem::initializeStarTiles(const SpatialIndex &index, const GalaxyQuadTree *quadTree, const sf::FloatRect &mapBoundary)
 {
-	// Create an off-screen render texture
-	sf::RenderTexture renderTexture;
-	renderTexture.create(renderWindow.getSize().x, renderWindow.getSize().y);
-	renderTexture.clear(sf::Color::Transparent);
+	starTiles.setStars(index, quadTree, mapBoundary);
+}
 
-	// Render stars onto the texture
-	for (const Star &star : stars)
+void RenderSystem::initializeStarLabels(const std::vector<Star> &stars)
+{
+	// Labels are placed in order until the screen fills up, so go by star ID rather than table order: the same
+	// stars get their names shown whichever spatial index sorted the table.
+	std::vector<std::pair<uint32_t, size_t>> namedStars; // ID, star table index
+	for (size_t starIndex = 0; starIndex < stars.size(); ++starIndex)
 	{
-		// Create a base circle slightly larger and darker
-		sf::CircleShape baseShape(3.5f);
-		baseShape.setPosition(static_cast<float>(star.getX()), static_cast<float>(star.getY()));
-		sf::Color darkerColor = star.getColour();
-		darkerColor.r = std::max(0, darkerColor.r - 50);
-		darkerColor.g = std::max(0, darkerColor.g - 50);
-		darkerColor.b = std::max(0, darkerColor.b - 50);
-		baseShape.setFillColor(darkerColor);
-		baseShape.setOrigin(baseShape.getRadius(), baseShape.getRadius());
-		renderTexture.draw(baseShape);
-
-		// Create a core circle with the star's color
-		sf::CircleShape coreShape(3.0f);
-		coreShape.setPosition(static_cast<float>(star.getX()), static_cast<float>(star.getY()));
-		coreShape.setFillColor(star.getColour());
-		coreShape.setOrigin(coreShape.getRadius(), coreShape.getRadius());
-		renderTexture.draw(coreShape);
-
-		// Create a smaller circle in the center with a slightly lighter shade
-		sf::CircleShape centerShape(2.5f);
-		centerShape.setPosition(static_cast<float>(star.getX()), static_cast<float>(star.getY()));
-		sf::Color lighterColor = star.getColour();
-		lighterColor.r = std::min(255, lighterColor.r + 50);
-		lighterColor.g = std::min(255, lighterColor.g + 50);
-		lighterColor.b = std::min(255, lighterColor.b + 50);
-		centerShape.setFillColor(lighterColor);
-		centerShape.setOrigin(centerShape.getRadius(), centerShape.getRadius());
-		renderTexture.draw(centerShape);
-
-		if (showTextLabelsStars)
+		const std::string &name = stars[starIndex].getName();
+		if (!name.empty() && name != "\"\"") // deal with stars with blank names that get populated as ""
 		{
-			if (!star.getName().empty() && star.getName() != "\"\"") // deal with stars with blank names that get populated as ""
-			{
-				// Render text labels if the flag is true
-
-				sf::Text labelText(star.getName(), font, 14);
-				// std::cout << "Text Label for Star will be: " << star.getName() << std::endl; // TOO VERBOSE
-				labelText.setPosition((star.getX()) + 10, (star.getY()) + 10);
-				renderTexture.draw(labelText);
-			}
+			namedStars.emplace_back(stars[starIndex].getID(), starIndex);
 		}
 	}
+	std::sort(namedStars.begin(), namedStars.end());
 
-	renderTexture.display();				   // dont remove this, makes texture appear upside down or go undefined position.
-	starsTexture = renderTexture.getTexture(); // Save the rendered texture
+	starLabels.resize(namedStars.size());
+	for (size_t label = 0; label < namedStars.size(); ++label)
+	{
+		const Star &star = stars[namedStars[label].second];
+		starLabels.setLabel(label, star.getName(), sf::Color::White);
+		starLabels.setAnchor(label, sf::Vector2f(static_cast<float>(star.getX()), static_cast<float>(star.getY())));
+	}
 }
 
-void RenderSystem::renderStars(const std::vector<Star> &stars)
+void RenderSystem::renderStars()
 {
-	sf::Sprite starsSprite(starsTexture); // Create a sprite from the pre-rendered texture
-	renderWindow.draw(starsSprite);		  // Draw the sprite onto the window
+	starTiles.draw(renderWindow);
 }
 
-void RenderSystem::renderProbe(const Probe &probe)
+void RenderSystem::renderStarLabels()
+{
+	if (showTextLabelsStars)
+	{
+		starLabels.draw(renderWindow);
+	}
+}
+
+void RenderSystem::renderProbes(const ProbeSystem &probeSystem)
 {
 	if (showProbeTrails)
 	{
-		const std::vector<VisitedStarSystem> &probeVisitedStarSystems = probe.getVisitedStarSystems();
-		sf::Color pathColor = probe.getTrailColor(); // Assuming you have a getter for the trail color in Probe
+		// Every trail in one draw call, whatever the view. Without a working vertex buffer, from the copy in memory.
+		updateProbeTrails(probeSystem);
+		if (useTrailBuffer)
+		{
+			renderWindow.draw(trailBuffer, 0, trailBufferedCount);
+		}
+		else if (!trailVertices.empty())
+		{
+			renderWindow.draw(trailVertices.data(), trailVertices.size(), sf::Lines);
+		}
+	}
 
-		if (probeVisitedStarSystems.size() >= 1)
+	// Probes are too many to draw one by one, so every probe becomes a square in one vertex array, coloured by its
+	// mode, and the lot goes to the GPU in a single draw call. Read straight from the probe system's arrays.
+	// Squares are sized in map units, so they are scaled to stay probeSize pixels across at any zoom.
+	float size = probeSize * renderWindow.getView().getSize().x / (renderWindow.getSize().x * renderWindow.getView().getViewport().width);
+	size_t probeCount = probeSystem.size();
+	probeVertices.resize(probeCount * 4);
+	for (size_t slot = 0; slot < probeCount; ++slot)
+	{
+		float x = probeSystem.getX(slot);
+		float y = probeSystem.getY(slot);
+		const sf::Color &colour = probeColours[static_cast<size_t>(probeSystem.getMode(slot))];
+		sf::Vertex *quad = &probeVertices[slot * 4];
+		quad[0].position = sf::Vector2f(x, y);
+		quad[1].position = sf::Vector2f(x + size, y);
+		quad[2].position = sf::Vector2f(x + size, y + size);
+		quad[3].position = sf::Vector2f(x, y + size);
+		quad[0].color = colour;
+		quad[1].color = colour;
+		quad[2].color = colour;
+		quad[3].color = colour;
+	}
+	renderWindow.draw(probeVertices);
+
+	if (showTextLabelsProbes)
+	{
+		// Names and colours never change, so only probes new since the last frame get their label set.
+		size_t labelledCount = probeLabels.size();
+		probeLabels.resize(probeCount);
+		for (size_t slot = labelledCount; slot < probeCount; ++slot)
+		{
+			probeLabels.setLabel(slot, probeSystem[slot].getProbeName(), probeSystem[slot].getTrailColor());
+		}
+		// Only probes that moved are re-placed; the rest keep their spot in the batch without a new layout.
+		for (size_t slot = 0; slot < probeCount; ++slot)
 		{
-			for (size_t i = 1; i < probeVisitedStarSystems.size(); ++i)
+			probeLabels.setAnchor(slot, sf::Vector2f(probeSystem.getX(slot), probeSystem.getY(slot)));
+		}
+		probeLabels.draw(renderWindow);
+	}
+}
+
+void RenderSystem::updateProbeTrails(const ProbeSystem &probeSystem)
+{
+	// Histories only grow, so a probe whose history is no longer than last frame has nothing new to draw. While
+	// trails are hidden nothing is collected, and the first frame they are shown again catches up.
+	size_t probeCount = probeSystem.size();
+	trailHistorySizes.resize(probeCount, 0);
+	for (size_t slot = 0; slot < probeCount; ++slot)
+	{
+		const Probe &probe = probeSystem[slot];
+		const VisitedStarHistory &history = probe.getVisitedStarSystems();
+		if (history.size() == trailHistorySizes[slot])
+		{
+			continue;
+		}
+
+		// Start one entry back, so the first new segment joins on to the last one already drawn.
+		sf::Color pathColor = probe.getTrailColor();
+		bool hasPrevSystem = false;
+		VisitedStarSystem prevSystem;
+		history.forEachSince(trailHistorySizes[slot] > 0 ? trailHistorySizes[slot] - 1 : 0, [&](const VisitedStarSystem &currentSystem)
+							 {
+			// A segment between two systems the probe visited itself; the ones inherited from a parent are its parent's to draw.
+			if (hasPrevSystem && currentSystem.visitedByProbe && prevSystem.visitedByProbe)
 			{
-				const VisitedStarSystem &currentSystem = probeVisitedStarSystems[i];
-				const VisitedStarSystem &prevSystem = probeVisitedStarSystems[i - 1];
-
-				if (currentSystem.visitedByProbe && prevSystem.visitedByProbe)
-				{
-					// Render a line segment between the current and previous star systems
-					sf::Vertex line[] = {
-						sf::Vertex(prevSystem.coordinates, pathColor),
-						sf::Vertex(currentSystem.coordinates, pathColor)};
-
-					renderWindow.draw(line, 2, sf::Lines);
-				}
+				trailVertices.push_back(sf::Vertex(prevSystem.coordinates, pathColor));
+				trailVertices.push_back(sf::Vertex(currentSystem.coordinates, pathColor));
 			}
-		}
+			prevSystem = currentSystem;
+			hasPrevSystem = true; });
+		trailHistorySizes[slot] = history.size();
 	}
 
-	// Render the probe at its current position outside the loop
-	sf::CircleShape probeShape(0.5f); // Adjust the radius as needed
-	probeShape.setPosition(probe.getX(), probe.getY());
-	probeShape.setFillColor(sf::Color(173, 216, 230));
-	// probeShape.setOrigin(probeShape.getRadius(), probeShape.getRadius()); // TODO - check if this hurts performance at high probe counts.
-	renderWindow.draw(probeShape);
-	if (showTextLabelsProbes)
+	if (!useTrailBuffer || trailBufferedCount == trailVertices.size())
+	{
+		return;
+	}
+	bool uploaded;
+	if (trailVertices.size() > trailBuffer.getVertexCount())
+	{
+		// Out of room: a buffer twice the size, filled from the copy in memory. Growing by doubling keeps the
+		// total uploaded to a small multiple of the trail size.
+		uploaded = trailBuffer.create(std::max<size_t>(trailVertices.size() * 2, 4096)) && trailBuffer.update(trailVertices.data(), trailVertices.size(), 0);
+	}
+	else
 	{
-		// Render probe text label if the flag is true
-		// std::string ajrtemp = probe.visitedStarSystemsToString();
-		sf::Text labelText(probe.getProbeName(), font, 10);
-		// sf::Text labelText(ajrtemp, font, 12);
-		labelText.setPosition((probe.getX()) - 10, (probe.getY()) - 10);
-		labelText.setColor(probe.getTrailColor());
-		renderWindow.draw(labelText);
+		uploaded = trailBuffer.update(trailVertices.data() + trailBufferedCount, trailVertices.size() - trailBufferedCount, static_cast<unsigned int>(trailBufferedCount));
 	}
+	if (!uploaded)
+	{
+		// The driver refused the buffer (SFML says why on the console), so trails are drawn from memory from now on.
+		std::cerr << "Error uploading probe trails; drawing them without a vertex buffer.\n";
+		useTrailBuffer = false;
+		return;
+	}
+	trailBufferedCount = trailVertices.size();
 }
 
 void RenderSystem::renderSummaryText(const std::string &summary)
@@ -158,7 +218,10 @@ void RenderSystem::renderSummaryText(const std::string &summary)
 	// Set the position, formatting, and other properties of the summary text
 	// Example:
 	summaryText.setPosition(10, 10); // Set the position of the text within the window
-	renderWindow.draw(summaryText);	 // Draw the summary text within the game loop
+	sf::View view = renderWindow.getView(); // in window pixels, whatever the camera is looking at
+	renderWindow.setView(renderWindow.getDefaultView());
+	renderWindow.draw(summaryText); // Draw the summary text within the game loop
+	renderWindow.setView(view);
 }
 
 void RenderSystem::calculateAndDisplayFPS()
@@ -174,39 +237,32 @@ void RenderSystem::calculateAndDisplayFPS()
 		ss << "FPS: " << static_cast<int>(fps);
 		fpsCounter.setString(ss.str());
 
-		// Draw FPS counter text
+		// Draw FPS counter text, in window pixels whatever the camera is looking at
+		sf::View view = renderWindow.getView();
+		renderWindow.setView(renderWindow.getDefaultView());
 		renderWindow.draw(fpsCounter);
+		renderWindow.setView(view);
 	}
 }
 
-void RenderSystem::renderQuadtree(sf::RenderWindow &window, GalaxyQuadTreeNode *node)
+void RenderSystem::renderQuadtree(sf::RenderWindow &window, const GalaxyQuadTree &quadTree)
 {
-	if (node == nullptr)
-	{
-		return;
-	}
-
 	if (showDebugGraphics)
 	{
-
-		sf::RectangleShape nodeRect;
-		nodeRect.setSize(sf::Vector2f(node->boundary.width, node->boundary.height));
-		nodeRect.setPosition(sf::Vector2f(node->boundary.left, node->boundary.top));
-		nodeRect.setFillColor(sf::Color::Transparent);
-		nodeRect.setOutlineThickness(0.5f);
-		int outlineRed = 55; // Replace these values with your desired RGB components (0-255)
-		int outlineGreen = 55;
-		int outlineBlue = 55;
-		int outlineAlpha = 128;
-		nodeRect.setOutlineColor(sf::Color(outlineRed, outlineGreen, outlineBlue, outlineAlpha));
-		window.draw(nodeRect);
-
-		if (!node->isLeaf)
+		// Every node's boundary is drawn, so just walk the node array rather than the tree.
+		for (const GalaxyQuadTreeNode &node : quadTree.getNodes())
 		{
-			for (int i = 0; i < 4; ++i)
-			{
-				renderQuadtree(window, node->getChild(i));
-			}
+			sf::RectangleShape nodeRect;
+			nodeRect.setSize(sf::Vector2f(node.boundary.width, node.boundary.height));
+			nodeRect.setPosition(sf::Vector2f(node.boundary.left, node.boundary.top));
+			nodeRect.setFillColor(sf::Color::Transparent);
+			nodeRect.setOutlineThickness(0.5f);
+			int outlineRed = 55; // Replace these values with your desired RGB components (0-255)
+			int outlineGreen = 55;
+			int outlineBlue = 55;
+			int outlineAlpha = 128;
+			nodeRect.setOutlineColor(sf::Color(outlineRed, outlineGreen, outlineBlue, outlineAlpha));
+			window.draw(nodeRect);
 		}
 	}
 }
\ No newline at end of file
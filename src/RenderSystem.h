@@ -2,41 +2,56 @@
 #ifndef RENDERSYSTEM_H
 #define RENDERSYSTEM_H
 
+#include "LoadConfig.h"
 #include "Probe.h"
+#include "ProbeSystem.h"
 #include "Star.h" // Assuming Star class is used for rendering
 #include <SFML/Graphics.hpp>
 #include <sstream>
 #include "GalaxyQuadTree.h"
 #include "GalaxyQuadTreeNode.h"
+#include "LabelLayer.h"
+#include "StarTileLayer.h"
 
 class RenderSystem
 {
 public:
-	RenderSystem(sf::RenderWindow &window);
+	RenderSystem(sf::RenderWindow &window, const LoadConfig &config);
 
-	void renderStars(const std::vector<Star> &stars);
-	void renderProbe(const Probe &probe); // Declaration for renderProbe
+	void renderStars(); // the star tiles covering the window's view
+	void renderStarLabels(); // names of the stars, if shown
+	void renderProbes(const ProbeSystem &probeSystem); // every probe body in one draw call, then trails and labels if shown
 	void renderSummaryText(const std::string &summary);
 	void toggleTextLabelsStars(); // Method to toggle text labels visibility
 	void toggleTextLabelsProbes();
 	void toggleProbeTrails();
 	void toggleDebugGraphics();									 // Method to toggle probe trails visibility
-	void initializeStarsTexture(const std::vector<Star> &stars); // Draw stars on a texture, then render that
-	const sf::Texture &getStarsTexture() const
-	{
-		return starsTexture;
-	}
+	void initializeStarTiles(const SpatialIndex &index, const GalaxyQuadTree *quadTree, const sf::FloatRect &mapBoundary); // stars are drawn from tiles, rasterised as views need them
+	void initializeStarLabels(const std::vector<Star> &stars);	 // one label per named star, shaped as they are first shown
 	void calculateAndDisplayFPS();
-	void renderQuadtree(sf::RenderWindow &window, GalaxyQuadTreeNode *node);
+	void renderQuadtree(sf::RenderWindow &window, const GalaxyQuadTree &quadTree);
 
 private:
 	sf::RenderWindow &renderWindow;
 	sf::Text summaryText; // Text object to display the summary
 	sf::Font font;
-	sf::Texture starsTexture;
+	StarTileLayer starTiles;
 	sf::Text fpsCounter;
 	sf::Clock fpsClock;
 	// void renderQuadtree(sf::RenderWindow &window, GalaxyQuadTreeNode *node);
+	void updateProbeTrails(const ProbeSystem &probeSystem); // append the trail segments recorded since the last frame
+	sf::VertexArray probeVertices; // one quad per probe, refilled each frame; keeps its storage between frames
+	float probeSize; // in screen pixels, whatever the zoom
+	sf::Color probeColours[4]; // indexed by ProbeMode
+	// Trails only ever grow, so they are kept from frame to frame in world coordinates (any view can draw them) and
+	// only new segments are added. trailVertices holds two per segment; trailBuffer is its copy on the GPU.
+	std::vector<sf::Vertex> trailVertices;
+	sf::VertexBuffer trailBuffer;
+	size_t trailBufferedCount;			   // vertices of trailVertices already in trailBuffer
+	bool useTrailBuffer;				   // vertex buffers are available and every upload to trailBuffer has worked
+	std::vector<size_t> trailHistorySizes; // per probe slot, history entries already turned into segments
+	LabelLayer starLabels;
+	LabelLayer probeLabels; // one per probe slot
 	bool showTextLabelsStars; // Flag to control visibility of text labels
 	bool showTextLabelsProbes;
 	bool showProbeTrails;	// Flag to control visibility of text labels
@@ -0,0 +1,422 @@
+// Simulation.cpp
+#include "Simulation.h"
+#include "LoadConfig.h"
+#include "LoadCSVData.h"
+#include "Probe.h"
+#include "ProbeSystem.h"
+#include "StarCatalogCache.h"
+#include "Utilities.h"
+#include "GalaxyQuadTree.h"
+#include "SpatialIndex.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <iostream>
+
+Simulation::Simulation(const LoadConfig &config) : config(config),
+												   mapBoundary(0.f, 0.f, config.getWindowWidth(), config.getWindowHeight()),
+												   spatialIndex(SpatialIndex::create(config.getSpatialIndex(), mapBoundary, config.getQuadTreeSearchSize(), config.getQuadTreeMaxDepth(), galaxyVector)),
+												   simulationTimeInSeconds(0.0),
+												   threadPool(config.getSimulationThreads()),
+												   probeSerialNumber(0)
+{
+	// The map is projected onto the configured window size, whether or not a window is ever opened.
+	sf::Vector2u mapSize(config.getWindowWidth(), config.getWindowHeight());
+
+	// Load star systems into GalaxyVector, and the spatial index over them. A cache from an earlier run with the same
+	// catalog and settings skips the CSV parsing, and for the quadtree the tree building too.
+	const std::string catalogPath = "./content/hygdata_v40.csv";
+	StarCatalogCache catalogCache(catalogPath, catalogPath + ".cache", mapSize, config);
+	GalaxyQuadTree *quadTree = dynamic_cast<GalaxyQuadTree *>(spatialIndex.get());
+	bool loadedFromCache = catalogCache.load(galaxyVector, quadTree);
+	if (!loadedFromCache)
+	{
+		LoadCSVData dataLoader2;
+		galaxyVector = dataLoader2.loadStarsFromCsv(catalogPath, mapSize, config, threadPool);
+	}
+	if (!galaxyVector.empty())
+	{
+		std::cout << "galaxyVector2 vector is populated with " << galaxyVector.size() << " stars" << (loadedFromCache ? " from the catalog cache." : ".") << std::endl;
+	}
+	else
+	{
+		std::cout << "galaxyVector vector is empty." << std::endl;
+	}
+
+	// Calculate the center coordinates
+	int centerX = mapSize.x / 2;
+	int centerY = mapSize.y / 2;
+
+	// Create a mapping table of star names to their ID values. Used for passing to probe namer.
+	Utilities::populateStarData(galaxyVector);
+
+	if (!loadedFromCache || quadTree == nullptr)
+	{
+		// Build the index over galaxyVector, which stays the only copy of each star. This sorts galaxyVector into
+		// spatial order, so nothing may hold star indices from before this point. The other indexes are not cached,
+		// but the cached stars are already in their order, which rebuilding keeps.
+		spatialIndex->build(threadPool);
+	}
+	if (!loadedFromCache && !galaxyVector.empty())
+	{
+		catalogCache.save(galaxyVector, quadTree);
+	}
+#if defined(_DEBUG)
+	// quadTree->debugPrint(); // This will print the structure of the quadtree and the stars in each node EXTREME VERBOSE!
+#endif
+
+	// The first probe starts at Sol (star ID 0), so nobody needs to travel there.
+	for (uint32_t starIndex = 0; starIndex < galaxyVector.size(); ++starIndex)
+	{
+		if (galaxyVector[starIndex].getID() == 0)
+		{
+			spatialIndex->markStarExplored(starIndex);
+		}
+	}
+
+	// Spawn the first probe - the quadtree as argument so star data is shared between probe instances.
+	Probe &firstProbe = probeSystem.spawn("SOL-SOL-AAA", centerX, centerY, 0.0f, *spatialIndex); // Example coordinates and speed
+	firstProbe.seedRandomGenerator(config.getWorldSeed() + probeSerialNumber++);
+	firstProbe.setMode(ProbeMode::Seek);
+	firstProbe.setNewBorn(false);
+	firstProbe.setRandomTrailColor();
+	sf::Vector2f SolCoordinates(centerX, centerY); // Replace these values with actual coordinates
+	firstProbe.addVisitedStarSystem(0, SolCoordinates, true);
+	firstProbe.setSpeed(1); // make sure starter system is set
+	firstProbe.move();		// currently running the actual logic of the probe from its class.
+	if (config.getEventDrivenSimulation())
+	{
+		trackProbe(0);
+	}
+}
+
+void Simulation::runHeadless()
+{
+	// No window to poll or draw, and no sleepTimeMillis throttle: just run the epochs back to back.
+	auto simulationStartTime = std::chrono::high_resolution_clock::now();
+	int simulationIterations = config.getSimulationIterations();
+
+	if (config.getEventDrivenSimulation())
+	{
+		advanceToTick(simulationIterations > 0 ? static_cast<uint32_t>(simulationIterations) : 0);
+	}
+	else
+	{
+		for (int iteration = 0; iteration < simulationIterations; ++iteration)
+		{
+			updateGameState();
+		}
+	}
+
+	auto simulationEndTime = std::chrono::high_resolution_clock::now();
+	std::chrono::duration<double> simulationDuration = simulationEndTime - simulationStartTime;
+	setSimulationTimeInSeconds(simulationDuration.count());
+	std::cout << "Simulation took " << simulationTimeInSeconds << " seconds." << std::endl;
+	generateSummary();
+}
+
+void Simulation::setSimulationTimeInSeconds(double seconds)
+{
+	simulationTimeInSeconds = seconds;
+}
+
+const std::vector<Star> &Simulation::getGalaxyVector() const
+{
+	return galaxyVector;
+}
+
+const ProbeSystem &Simulation::getProbeSystem() const
+{
+	return probeSystem;
+}
+
+SpatialIndex &Simulation::getSpatialIndex()
+{
+	return *spatialIndex;
+}
+
+const sf::FloatRect &Simulation::getMapBoundary() const
+{
+	return mapBoundary;
+}
+
+const GalaxyQuadTree *Simulation::getQuadTree() const
+{
+	return dynamic_cast<const GalaxyQuadTree *>(spatialIndex.get());
+}
+
+void Simulation::updateGameState()
+{
+	if (config.getEventDrivenSimulation())
+	{
+		advanceToTick(probeSystem.getCurrentTick() + 1);
+		// Only worked out when a frame needs them: where the probes in transit are part way through their legs.
+		threadPool.parallelFor(probeSystem.size(), [this](size_t begin, size_t end)
+							   { probeSystem.advanceTravellingProbes(begin, end); });
+		return;
+	}
+	probeSystem.setCurrentTick(probeSystem.getCurrentTick() + 1);
+
+	// Phase 1 (parallel): every probe plans its target search against the star state as it stands at the start of the tick.
+	// Nothing is written to shared state here, so the result does not depend on the number of threads.
+	size_t plannedProbeCount = probeSystem.size();
+	probeIntents.resize(plannedProbeCount);
+	threadPool.parallelFor(plannedProbeCount, [this](size_t begin, size_t end)
+						   {
+		for (size_t i = begin; i < end; ++i)
+		{
+			probeIntents[i] = probeSystem[i].planStep();
+		} });
+
+	// Phase 2 (serial): replications, target claims and movement are applied in probe order, the same for any thread count.
+	std::vector<size_t> probesToReplicate; // Store indices of probes to replicate
+
+	// Find probes that need to replicate
+	for (size_t i = 0; i < plannedProbeCount; ++i)
+	{
+		if (probeSystem[i].getMode() == ProbeMode::Replicate)
+		{
+			// Store the index of the probe that needs replication
+			probesToReplicate.push_back(i);
+		}
+	}
+
+	// TODO: Can we move logic together into probe class itself?
+	// Create new probes based on probesToReplicate. Children are spawned straight into the probe system, after every
+	// existing slot, so they are in the same order the old add-them-later vector gave.
+	for (const auto &index : probesToReplicate)
+	{
+		replicateProbe(index);
+	}
+
+	// Travel (parallel): step every travelling probe with the SoA kernel. It only touches each probe's own slot.
+	size_t probeCount = probeSystem.size();
+	threadPool.parallelFor(probeCount, [this](size_t begin, size_t end)
+						   { probeSystem.advanceTravellingProbes(begin, end); });
+
+	// Move all probes after handling replication, in probe order. Arrivals claim nothing, but they do write star
+	// state and probe histories, so they stay on this thread too. Probes created this tick had no planning phase,
+	// so get an empty intent.
+	for (size_t i = 0; i < probeCount; ++i)
+	{
+		if (probeSystem.hasArrived(i))
+		{
+			probeSystem[i].arrive();
+		}
+		else if (probeSystem[i].getMode() != ProbeMode::Travel)
+		{
+			probeSystem[i].move(i < plannedProbeCount ? probeIntents[i] : ProbeIntent{false, SpatialIndex::InvalidIndex}); // Execute the movement logic for each probe
+		}
+	}
+
+	// Add your game logic for updating the state here
+}
+
+void Simulation::replicateProbe(size_t index)
+{
+	// Run specific logic when the mode is "Replicate"
+
+	if (probeSystem[index].getReplicationCount() >= config.getprobeIndividualReplicationLimit())
+	{
+		probeSystem[index].setMode(ProbeMode::Shutdown);
+	}
+	else
+	{ // if probe hasnt reached its replication limit, do some replicating. shouldnt we be doing this before a probe goes into replication mode?!
+		// Create a new replicated probe
+		// must be using targetStar name to generate the child probe name string.
+		// first arg is used as parent name, second string as replication location.
+
+		// Need to convert current location ID to string name. use utility class.
+		uint32_t replicationLocationID;																 // declare new varaible
+		replicationLocationID = probeSystem[index].getTargetStar();									 // get the probes current target ID
+		std::string replicationLocationName = Utilities::getStarNameFromID(replicationLocationID); // pass target ID into lookup utility, returns string of system name.
+
+		std::string newName = Utilities::probeNamer((probeSystem[index].getProbeName()), replicationLocationName);
+		// spawn may grow the probe arrays, so only take references to the parent after it.
+		Probe &replicatedProbe = probeSystem.spawn(newName, probeSystem[index].getX(), probeSystem[index].getY(), probeSystem[index].getSpeed(), *spatialIndex);
+		Probe &probe = probeSystem[index];
+
+		replicatedProbe.setRandomTrailColor();
+		replicatedProbe.seedRandomGenerator(config.getWorldSeed() + probeSerialNumber++);
+
+		// Share the visited star systems of the original probe with the replicated probe. Nothing is copied, and
+		// the child sees those entries as visited by a parent rather than by itself.
+		replicatedProbe.inheritVisitedStarSystems(probe);
+
+		// Get next target Star for current probe, pass this as a visted system to child so the child heads elsewhere.
+		uint32_t parentProbeNextTargetIndex = probe.resolveNextTarget(probeIntents[index]);
+		if (parentProbeNextTargetIndex != SpatialIndex::InvalidIndex)
+		{
+			const Star *parentProbeNextTarget = &spatialIndex->getStar(parentProbeNextTargetIndex);
+			// convert the star xy into a vector object
+			replicatedProbe.addVisitedStarSystem(parentProbeNextTarget->getID(), sf::Vector2f(parentProbeNextTarget->getX(), parentProbeNextTarget->getY()), false);
+
+			// debug here
+		}
+		else
+		{
+			// Handle the case where no nearest unvisited star was found
+		}
+
+		// TODO: Logic for updating star isExplored property
+	}
+}
+
+void Simulation::trackProbe(uint32_t slot)
+{
+	// Event-driven engine bookkeeping: a probe in transit sleeps until its arrival, seeking and replicating probes
+	// act every tick, and shut down probes are never looked at again.
+	ProbeMode mode = probeSystem[slot].getMode();
+	if (mode == ProbeMode::Travel)
+	{
+		arrivalEvents.push(ArrivalEvent(probeSystem.getArrivalTick(slot), slot));
+	}
+	else if (mode == ProbeMode::Seek || mode == ProbeMode::Replicate)
+	{
+		awakeProbes.push_back(slot);
+	}
+}
+
+void Simulation::advanceToTick(uint32_t lastTick)
+{
+	// Jump straight from one tick where something happens to the next. Ticks where every probe is in transit are skipped.
+	while (true)
+	{
+		uint32_t nextTick;
+		if (!awakeProbes.empty())
+		{
+			nextTick = probeSystem.getCurrentTick() + 1;
+		}
+		else if (!arrivalEvents.empty())
+		{
+			nextTick = arrivalEvents.top().first;
+		}
+		else
+		{
+			break; // every probe has shut down
+		}
+
+		if (nextTick > lastTick)
+		{
+			break;
+		}
+		processEventTick(nextTick);
+	}
+	probeSystem.setCurrentTick(lastTick);
+}
+
+void Simulation::processEventTick(uint32_t tick)
+{
+	// The same three steps as a tick of updateGameState, applied only to the probes whose state changes this tick.
+	probeSystem.setCurrentTick(tick);
+
+	// Events come off the queue in slot order for a given tick, so this list is already sorted.
+	arrivingProbes.clear();
+	while (!arrivalEvents.empty() && arrivalEvents.top().first == tick)
+	{
+		arrivingProbes.push_back(arrivalEvents.top().second);
+		arrivalEvents.pop();
+	}
+
+	// Phase 1 (parallel): plan for the probes that are seeking or replicating.
+	size_t plannedProbeCount = probeSystem.size();
+	probeIntents.resize(plannedProbeCount);
+	threadPool.parallelFor(awakeProbes.size(), [this](size_t begin, size_t end)
+						   {
+		for (size_t i = begin; i < end; ++i)
+		{
+			probeIntents[awakeProbes[i]] = probeSystem[awakeProbes[i]].planStep();
+		} });
+
+	// Phase 2 (serial): replications in probe order.
+	for (uint32_t slot : awakeProbes)
+	{
+		if (probeSystem[slot].getMode() == ProbeMode::Replicate)
+		{
+			replicateProbe(slot);
+		}
+	}
+
+	// Phase 3 (serial): arrivals and moves in probe order, then the children spawned this tick.
+	touchedProbes.clear();
+	std::merge(awakeProbes.begin(), awakeProbes.end(), arrivingProbes.begin(), arrivingProbes.end(), std::back_inserter(touchedProbes));
+	for (size_t slot = plannedProbeCount; slot < probeSystem.size(); ++slot)
+	{
+		touchedProbes.push_back(static_cast<uint32_t>(slot));
+	}
+
+	awakeProbes.clear();
+	for (uint32_t slot : touchedProbes)
+	{
+		Probe &probe = probeSystem[slot];
+		if (probe.getMode() == ProbeMode::Travel)
+		{
+			probe.arrive(); // only probes arriving this tick are in the list while travelling
+		}
+		else
+		{
+			probe.move(slot < plannedProbeCount ? probeIntents[slot] : ProbeIntent{false, SpatialIndex::InvalidIndex});
+		}
+		trackProbe(slot);
+	}
+}
+
+void Simulation::generateSummary() const
+{
+	// Collect and display header summary statistics here
+	std::cout << "-----------------" << '\n'
+			  << "Begin Summary: " << '\n'
+			  << "-----------------" << '\n';
+
+	if (config.getSummaryShowPerProbe())
+	{
+		for (const auto &probe : probeSystem)
+		{
+			if (probe.getTotalDistanceTraveled() > 0 && probe.getReplicationCount() > 0)
+			{
+				std::cout << "- Probe Name: [" << probe.getProbeName() << "] Traveled [" << probe.getTotalDistanceTraveled() << "], replicated [" << probe.getReplicationCount() << "] times,"
+						  << "visiting ";
+
+				probe.getVisitedStarSystems().forEach([](const VisitedStarSystem &visitedSystem)
+													  {
+					if (visitedSystem.visitedByProbe)
+					{
+						std::cout << "[" << visitedSystem.starID << "];";
+					} });
+				std::cout << std::endl;
+			}
+		}
+	}
+	// Footer statistics if needed (total distance, total replications, etc.)
+
+	int summarySeed = config.getWorldSeed();
+	int summaryIterations = config.getSimulationIterations();
+	size_t probeCount = probeSystem.size();
+
+	size_t totalStarsVisitedByProbes = 0;
+
+	for (const auto &star : galaxyVector)
+	{
+		if (star.getIsExplored())
+		{
+			totalStarsVisitedByProbes++;
+		}
+	}
+	double maxPossibleEfficiencyScore = 1;
+	double efficiencyScore = totalStarsVisitedByProbes / (simulationTimeInSeconds * probeCount);
+	double efficiencyPercentage = (efficiencyScore / maxPossibleEfficiencyScore) * 100.0;
+
+	if (config.getSummaryShowFooter())
+	{
+		// show summary footer is true
+		std::cout << "Simulation Summary:" << '\n'
+				  << "World Seed is [" << summarySeed << "] and Simulation limited to [" << summaryIterations << "] epochs" << '\n'
+				  << "Total number of stars: " << galaxyVector.size() << '\n'
+				  << "Total number of probes: " << probeCount << '\n'
+				  << "Total Simulation Time: " << simulationTimeInSeconds << " seconds." << '\n'
+				  // TODO - FIX and workout what a perfect score is on this. aparantly min number for 7 stars is 3 probes.
+				  << "Efficiency Ratio: " << efficiencyScore << '\n'
+				  << "Efficiency Percent: " << efficiencyPercentage << '\n'
+				  << "-----------------" << std::endl;
+	}
+}
@@ -0,0 +1,62 @@
+// Simulation.h
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "LoadConfig.h"
+#include "LoadCSVData.h"
+#include "Probe.h"
+#include "ProbeSystem.h"
+#include "Star.h"
+#include "GalaxyQuadTree.h"
+#include "SpatialIndex.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// The window-free core of the simulation. Owns the star catalog, the quadtree and every probe, and can be
+// stepped by the windowed Game or run on its own in headless mode (no sf::RenderWindow, no GL context).
+class Simulation
+{
+public:
+	Simulation(const LoadConfig &config);
+	void updateGameState();	// run one epoch of probe logic (replication, seeking, travel)
+	void advanceToTick(uint32_t lastTick); // event-driven engine: process every epoch up to lastTick where a probe's state changes
+	void runHeadless();		// run all configured epochs at full speed, then print the summary
+	void generateSummary() const;
+	void setSimulationTimeInSeconds(double seconds);
+
+	const std::vector<Star> &getGalaxyVector() const;
+	const ProbeSystem &getProbeSystem() const;
+	SpatialIndex &getSpatialIndex();
+	const sf::FloatRect &getMapBoundary() const; // the area star positions are projected into, in map coordinates
+	const GalaxyQuadTree *getQuadTree() const; // nullptr unless spatialIndex is "quadtree"
+
+private:
+	typedef std::pair<uint32_t, uint32_t> ArrivalEvent; // (arrival tick, probe slot)
+
+	void replicateProbe(size_t index);
+	void trackProbe(uint32_t slot); // queue the probe's next event after its state changed
+	void processEventTick(uint32_t tick);
+
+	const LoadConfig &config; // Member variable to hold the LoadConfig object
+	std::vector<Star> galaxyVector;
+	ProbeSystem probeSystem; // every probe in the simulation, looped through for logic/render.
+	sf::FloatRect mapBoundary;
+	std::unique_ptr<SpatialIndex> spatialIndex; // the backend picked by the spatialIndex setting
+	double simulationTimeInSeconds;
+	ThreadPool threadPool;					// runs catalog parsing and the per-probe planning phase of each tick
+	std::vector<ProbeIntent> probeIntents; // planning results, indexed by probe slot
+	uint32_t probeSerialNumber;				// counts probes created, to seed each one's random generator differently
+
+	// Event-driven engine state (simulationEngine "event")
+	std::priority_queue<ArrivalEvent, std::vector<ArrivalEvent>, std::greater<ArrivalEvent>> arrivalEvents; // probes in transit, earliest arrival first
+	std::vector<uint32_t> awakeProbes;	   // seeking or replicating probes, in slot order; they act every tick
+	std::vector<uint32_t> arrivingProbes; // scratch lists for processEventTick
+	std::vector<uint32_t> touchedProbes;
+};
+
+#endif // SIMULATION_H
@@ -0,0 +1,125 @@
+// SpatialIndex.cpp
+#include "SpatialIndex.h"
+#include "GalaxyQuadTree.h"
+#include "KdTreeIndex.h"
+#include "UniformGridIndex.h"
+#include <algorithm>
+
+std::unique_ptr<SpatialIndex> SpatialIndex::create(const std::string &type, const sf::FloatRect &boundary, int bucketSize, int maxDepth, std::vector<Star> &starTable)
+{
+	if (type == "grid")
+	{
+		return std::unique_ptr<SpatialIndex>(new UniformGridIndex(boundary, bucketSize, starTable));
+	}
+	if (type == "kdtree")
+	{
+		return std::unique_ptr<SpatialIndex>(new KdTreeIndex(boundary, bucketSize, starTable));
+	}
+	return std::unique_ptr<SpatialIndex>(new GalaxyQuadTree(boundary, bucketSize, maxDepth, starTable));
+}
+
+SpatialIndex::SpatialIndex(std::vector<Star> &starTable) : starTable(starTable)
+{
+}
+
+SpatialIndex::~SpatialIndex()
+{
+}
+
+uint32_t SpatialIndex::findNearest(const sf::Vector2f &point, const StarFilter &filter, float maxDistance, uint32_t hint) const
+{
+	static thread_local std::vector<uint32_t> nearest;
+	searchNearest(point, 1, filter, nearest, maxDistance, hint, false);
+	return nearest.empty() ? InvalidIndex : nearest.front();
+}
+
+void SpatialIndex::findKNearest(const sf::Vector2f &point, size_t k, const StarFilter &filter, std::vector<uint32_t> &results, float maxDistance, uint32_t hint) const
+{
+	searchNearest(point, k, filter, results, maxDistance, hint, false);
+}
+
+uint32_t SpatialIndex::findNearestAvailable(const sf::Vector2f &point, const StarFilter &filter, float maxDistance, uint32_t hint) const
+{
+	static thread_local std::vector<uint32_t> nearest;
+	searchNearest(point, 1, filter, nearest, maxDistance, hint, true);
+	return nearest.empty() ? InvalidIndex : nearest.front();
+}
+
+uint32_t SpatialIndex::locate(const sf::Vector2f &, uint32_t) const
+{
+	return 0; // no hints, every search starts from the top
+}
+
+bool SpatialIndex::claimStar(uint32_t starIndex)
+{
+	if (!starTable[starIndex].tryClaim())
+	{
+		return false;
+	}
+	availableStarCountChanged(starIndex, -1);
+	return true;
+}
+
+void SpatialIndex::releaseStar(uint32_t starIndex)
+{
+	if (starTable[starIndex].releaseClaim())
+	{
+		availableStarCountChanged(starIndex, 1);
+	}
+}
+
+void SpatialIndex::markStarExplored(uint32_t starIndex)
+{
+	// A claimed star already stopped being available when it was claimed.
+	if (starTable[starIndex].markExplored())
+	{
+		availableStarCountChanged(starIndex, -1);
+	}
+}
+
+void SpatialIndex::availableStarCountChanged(uint32_t, int)
+{
+}
+
+float SpatialIndex::distanceSquaredToRect(const sf::Vector2f &point, const sf::FloatRect &rect)
+{
+	float dx = std::max(std::max(rect.left - point.x, 0.0f), point.x - (rect.left + rect.width));
+	float dy = std::max(std::max(rect.top - point.y, 0.0f), point.y - (rect.top + rect.height));
+	return dx * dx + dy * dy;
+}
+
+void SpatialIndex::NearestCandidates::reset(size_t k, float maxDistanceSquared)
+{
+	candidates.clear();
+	this->k = k;
+	this->maxDistanceSquared = maxDistanceSquared;
+}
+
+float SpatialIndex::NearestCandidates::getBound() const
+{
+	return candidates.size() < k ? maxDistanceSquared : candidates.back().first;
+}
+
+void SpatialIndex::NearestCandidates::offer(float distanceSquared, uint32_t starIndex)
+{
+	std::pair<float, uint32_t> candidate(distanceSquared, starIndex);
+	if (k == 0 || distanceSquared > maxDistanceSquared || (candidates.size() == k && !(candidate < candidates.back())))
+	{
+		return;
+	}
+	// k is small (usually 1), so keeping the list sorted by insertion is cheaper than a heap.
+	if (candidates.size() == k)
+	{
+		candidates.pop_back();
+	}
+	candidates.insert(std::upper_bound(candidates.begin(), candidates.end(), candidate), candidate);
+}
+
+void SpatialIndex::NearestCandidates::copyTo(std::vector<uint32_t> &results) const
+{
+	results.clear();
+	for (const std::pair<float, uint32_t> &candidate : candidates)
+	{
+		results.push_back(candidate.second);
+	}
+}
@@ -0,0 +1,90 @@
+// SpatialIndex.h
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include "Star.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Finds stars by position. The simulation only talks to this interface, so the structure behind it is picked with
+// the spatialIndex config setting: "quadtree" (GalaxyQuadTree), "grid" (UniformGridIndex) or "kdtree" (KdTreeIndex).
+// Stars are referred to by their index in the star table the index was built over. Only stars inside the map
+// boundary are indexed.
+class SpatialIndex
+{
+public:
+	static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max(); // "no star" result for index lookups
+	typedef std::function<bool(uint32_t)> StarFilter;								// return true if the star (by index) may be returned by a search
+
+	// type is a spatialIndex config value. bucketSize is the stars per leaf or cell to aim for (quadtreeSearchSize).
+	static std::unique_ptr<SpatialIndex> create(const std::string &type, const sf::FloatRect &boundary, int bucketSize, int maxDepth, std::vector<Star> &starTable);
+
+	explicit SpatialIndex(std::vector<Star> &starTable);
+	virtual ~SpatialIndex();
+
+	// Build over the whole star table. Every index reorders the table so neighbouring stars sit together, so star
+	// indices change. Building again over a table this index already ordered leaves the order as it is.
+	virtual void build(ThreadPool &threadPool) = 0;
+
+	// Nearest neighbour searches. maxDistance is optional. hint is a value from locate for a point near this one,
+	// which lets an index start the search close by; 0 always works. Ties are broken by star index, so results repeat.
+	uint32_t findNearest(const sf::Vector2f &point, const StarFilter &filter, float maxDistance = std::numeric_limits<float>::infinity(), uint32_t hint = 0) const;
+	void findKNearest(const sf::Vector2f &point, size_t k, const StarFilter &filter, std::vector<uint32_t> &results, float maxDistance = std::numeric_limits<float>::infinity(), uint32_t hint = 0) const; // results are nearest first
+	uint32_t findNearestAvailable(const sf::Vector2f &point, const StarFilter &filter, float maxDistance = std::numeric_limits<float>::infinity(), uint32_t hint = 0) const; // only available stars, skipping areas that have none left
+	virtual uint32_t locate(const sf::Vector2f &point, uint32_t hint = 0) const; // search hint for point, starting from an older hint
+
+	// Range searches, in no particular order. results is cleared first.
+	virtual void findInRadius(const sf::Vector2f &center, float radius, std::vector<uint32_t> &results) const = 0; // distance <= radius
+	virtual void findInRect(const sf::FloatRect &rect, std::vector<uint32_t> &results) const = 0;					  // rect.contains(star)
+
+	// Star state changes go through the index, so it can keep track of where available (unclaimed, unexplored) stars are left.
+	bool claimStar(uint32_t starIndex);		  // Star::tryClaim
+	void releaseStar(uint32_t starIndex);	  // Star::releaseClaim
+	void markStarExplored(uint32_t starIndex); // Star::markExplored
+	Star &getStar(uint32_t starIndex)		  // Single authoritative star, so state changes are seen by everyone
+	{
+		return starTable[starIndex];
+	}
+	const Star &getStar(uint32_t starIndex) const
+	{
+		return starTable[starIndex];
+	}
+	const std::vector<Star> &getStars() const
+	{
+		return starTable;
+	}
+
+protected:
+	// The backend's search. With availableOnly, only available stars may be returned (filter is applied as well).
+	virtual void searchNearest(const sf::Vector2f &point, size_t k, const StarFilter &filter, std::vector<uint32_t> &results, float maxDistance, uint32_t hint, bool availableOnly) const = 0;
+	virtual void availableStarCountChanged(uint32_t starIndex, int delta); // a star became available (+1) or stopped being available (-1)
+
+	static float distanceSquaredToRect(const sf::Vector2f &point, const sf::FloatRect &rect); // 0 inside the rect
+
+	// The k nearest stars offered so far, nearest first. Equal distances go to the lower star index.
+	class NearestCandidates
+	{
+	public:
+		void reset(size_t k, float maxDistanceSquared);
+		float getBound() const; // anything further than this cannot get in
+		void offer(float distanceSquared, uint32_t starIndex);
+		void copyTo(std::vector<uint32_t> &results) const;
+
+	private:
+		std::vector<std::pair<float, uint32_t>> candidates;
+		size_t k;
+		float maxDistanceSquared;
+	};
+
+	std::vector<Star> &starTable; // The star catalog owned by Simulation; the index only holds indices into it
+};
+
+#endif // SPATIALINDEX_H
@@ -1,5 +1,6 @@
 // Star.cpp
 #include "Star.h"
+#include <utility>
 
 Star::Star(uint32_t ID, int x, int y, const std::string &name, const sf::Color &colour) : ID(ID),
 																						  x(x),
@@ -9,11 +10,52 @@ Star::Star(uint32_t ID, int x, int y, const std::string &name, const sf::Color &
 																						  // metals(metals),
 																						  // polymers(polymers),
 																						  // fuel(fuel),
-																						  isExplored(false)
+																						  state(StarState::Unclaimed)
 {
 	// why does this have to be here?
 }
 
+// std::atomic cannot be copied, so copies take a snapshot of the state.
+Star::Star(const Star &other) : ID(other.ID),
+								x(other.x),
+								y(other.y),
+								name(other.name),
+								colour(other.colour),
+								state(other.state.load())
+{
+}
+
+Star::Star(Star &&other) noexcept : ID(other.ID),
+								   x(other.x),
+								   y(other.y),
+								   name(std::move(other.name)),
+								   colour(other.colour),
+								   state(other.state.load())
+{
+}
+
+Star &Star::operator=(const Star &other)
+{
+	ID = other.ID;
+	x = other.x;
+	y = other.y;
+	name = other.name;
+	colour = other.colour;
+	state.store(other.state.load());
+	return *this;
+}
+
+Star &Star::operator=(Star &&other) noexcept
+{
+	ID = other.ID;
+	x = other.x;
+	y = other.y;
+	name = std::move(other.name);
+	colour = other.colour;
+	state.store(other.state.load());
+	return *this;
+}
+
 u_int32_t Star::getID() const
 {
 	return ID;
@@ -58,7 +100,17 @@ double Star::getFuel() const
 
 bool Star::getIsExplored() const
 {
-	return isExplored;
+	return state.load() == StarState::Explored;
+}
+
+bool Star::getIsClaimed() const
+{
+	return state.load() == StarState::Claimed;
+}
+
+bool Star::getIsAvailable() const
+{
+	return state.load() == StarState::Unclaimed;
 }
 
 // Setters
@@ -81,5 +133,22 @@ void Star::setFuel(double newFuelValue)
 
 void Star::setIsExplored(bool newIsExploredValue)
 {
-	isExplored = newIsExploredValue;
+	state.store(newIsExploredValue ? StarState::Explored : StarState::Unclaimed);
+}
+
+bool Star::markExplored()
+{
+	return state.exchange(StarState::Explored) == StarState::Unclaimed;
+}
+
+bool Star::tryClaim()
+{
+	StarState expected = StarState::Unclaimed;
+	return state.compare_exchange_strong(expected, StarState::Claimed);
+}
+
+bool Star::releaseClaim()
+{
+	StarState expected = StarState::Claimed;
+	return state.compare_exchange_strong(expected, StarState::Unclaimed);
 }
\ No newline at end of file
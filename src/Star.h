@@ -3,18 +3,39 @@
 #define STAR_H
 
 #include <SFML/Graphics/Color.hpp>
+#include <atomic>
+#include <cstdint>
 #include <string>
+
+// Exploration state shared by every probe. A star moves Unclaimed -> Claimed when a probe picks it as a target,
+// and Claimed -> Explored when that probe arrives (or back to Unclaimed if the probe shuts down on the way).
+enum class StarState : uint8_t
+{
+	Unclaimed,
+	Claimed,
+	Explored
+};
+
 class Star
 {
 public:
 	Star(uint32_t ID, int x, int y, const std::string &name, const sf::Color &colour);
+	Star(const Star &other);
+	Star(Star &&other) noexcept;
+	Star &operator=(const Star &other);
+	Star &operator=(Star &&other) noexcept;
 	uint32_t getID() const;
 	int getX() const;
 	int getY() const;
 	std::string getName() const;
 	sf::Color getColour() const;
 	bool getIsExplored() const;
+	bool getIsClaimed() const;
+	bool getIsAvailable() const; // neither claimed nor explored, so free to become a probe's target
 	void setIsExplored(bool newIsExploredValue);
+	bool markExplored(); // atomic exchange to Explored, true if the star was still available (Unclaimed) before
+	bool tryClaim();	 // atomic compare-and-swap Unclaimed -> Claimed, false if another probe got there first
+	bool releaseClaim(); // Claimed -> Unclaimed, for a probe that gives up on its target. False if it was not claimed
 
 private:
 	uint32_t ID;
@@ -22,7 +43,7 @@ private:
 	int y;
 	std::string name;
 	sf::Color colour;
-	bool isExplored;
+	std::atomic<StarState> state;
 };
 
-#endif // STAR_H
\ No newline at end of file
+#endif // STAR_H
@@ -0,0 +1,280 @@
+// StarCatalogCache.cpp
+#include "StarCatalogCache.h"
+#include "MappedFile.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <type_traits>
+
+namespace
+{
+	const char CacheMagic[8] = {'S', 'T', 'A', 'R', 'C', 'A', 'C', 'H'};
+	const uint32_t CacheVersion = 5; // 2: star table in Z-order, 3: flat node array, leaves are star table ranges, 4: parent links, 5: depth clamped to GalaxyQuadTree::MaxSupportedDepth
+	const uint32_t ByteOrderMark = 0x01020304; // reads differently on a machine of the other endianness
+
+	// All sections are made of 4-byte fields and the header is a multiple of 8 bytes, so every record in the
+	// mapping is correctly aligned and can be read in place.
+	struct CacheHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t byteOrderMark;
+		uint64_t key;
+		uint32_t starCount;
+		uint32_t nodeCount;
+		uint32_t stringPoolSize; // bytes of star names, not null terminated
+		uint32_t padding;
+		uint64_t reserved;
+	};
+
+	struct StarRecord
+	{
+		uint32_t id;
+		int32_t x;
+		int32_t y;
+		uint32_t nameOffset; // into the string pool
+		uint32_t nameLength;
+		uint8_t colour[4]; // r, g, b, a
+	};
+
+	struct NodeRecord
+	{
+		float left;
+		float top;
+		float width;
+		float height;
+		uint32_t firstChild; // node index, GalaxyQuadTreeNode::NoChildren for a leaf
+		uint32_t firstStar;	 // star table range covered by the node
+		uint32_t starCount;
+		uint32_t parent; // node index, GalaxyQuadTreeNode::NoParent for the root
+	};
+
+	static_assert(sizeof(CacheHeader) % 8 == 0, "cache header must keep the records after it aligned");
+	static_assert(std::is_trivially_copyable<StarRecord>::value && std::is_trivially_copyable<NodeRecord>::value, "cache records are read in place");
+
+	// 64-bit hash, 8 bytes per step. Only needs to tell catalog versions apart, not resist attacks.
+	uint64_t hashBytes(const char *data, size_t size, uint64_t hash)
+	{
+		const uint64_t multiplier = 0x9E3779B97F4A7C15ull;
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			uint64_t word;
+			std::memcpy(&word, data + i, 8);
+			hash = (hash ^ word) * multiplier;
+			hash ^= hash >> 29;
+		}
+		for (; i < size; ++i)
+		{
+			hash = (hash ^ static_cast<unsigned char>(data[i])) * multiplier;
+		}
+		hash ^= size;
+		hash ^= hash >> 32;
+		return hash;
+	}
+
+	uint64_t hashValue(uint64_t value, uint64_t hash)
+	{
+		char bytes[sizeof(value)];
+		std::memcpy(bytes, &value, sizeof(value));
+		return hashBytes(bytes, sizeof(bytes), hash);
+	}
+}
+
+StarCatalogCache::StarCatalogCache(const std::string &sourcePath, const std::string &cachePath, const sf::Vector2u &mapSize, const LoadConfig &config) : cachePath(cachePath),
+																																						   key(0),
+																																						   usable(false)
+{
+	MappedFile sourceFile(sourcePath);
+	if (!sourceFile.isOpen())
+	{
+		return;
+	}
+	std::string_view contents = sourceFile.getContents();
+	key = hashBytes(contents.data(), contents.size(), CacheVersion);
+	key = hashValue(static_cast<uint64_t>(config.getScaleFactor()), key);
+	key = hashValue(static_cast<uint64_t>(mapSize.x), key);
+	key = hashValue(static_cast<uint64_t>(mapSize.y), key);
+	key = hashValue(static_cast<uint64_t>(config.getLoadStarsLimit()), key);
+	key = hashBytes(config.getSpatialIndex().data(), config.getSpatialIndex().size(), key);
+	key = hashValue(static_cast<uint64_t>(config.getQuadTreeSearchSize()), key);
+	key = hashValue(static_cast<uint64_t>(config.getQuadTreeMaxDepth()), key);
+	usable = true;
+}
+
+bool StarCatalogCache::isUsable() const
+{
+	return usable;
+}
+
+bool StarCatalogCache::load(std::vector<Star> &stars, GalaxyQuadTree *quadTree) const
+{
+	if (!usable)
+	{
+		return false;
+	}
+	MappedFile cacheFile(cachePath);
+	std::string_view contents = cacheFile.getContents();
+	if (contents.size() < sizeof(CacheHeader))
+	{
+		return false;
+	}
+
+	const CacheHeader *header = reinterpret_cast<const CacheHeader *>(contents.data());
+	if (std::memcmp(header->magic, CacheMagic, sizeof(CacheMagic)) != 0 || header->version != CacheVersion || header->byteOrderMark != ByteOrderMark || header->key != key)
+	{
+		return false;
+	}
+
+	uint64_t expectedSize = sizeof(CacheHeader) + uint64_t(header->starCount) * sizeof(StarRecord) + uint64_t(header->nodeCount) * sizeof(NodeRecord) + header->stringPoolSize;
+	if (contents.size() != expectedSize)
+	{
+		return false; // truncated or written by something else
+	}
+
+	const StarRecord *starRecords = reinterpret_cast<const StarRecord *>(contents.data() + sizeof(CacheHeader));
+	const NodeRecord *nodeRecords = reinterpret_cast<const NodeRecord *>(starRecords + header->starCount);
+	const char *stringPool = reinterpret_cast<const char *>(nodeRecords + header->nodeCount);
+
+	std::vector<Star> cachedStars;
+	cachedStars.reserve(header->starCount);
+	for (uint32_t i = 0; i < header->starCount; ++i)
+	{
+		const StarRecord &record = starRecords[i];
+		if (record.nameOffset > header->stringPoolSize || record.nameLength > header->stringPoolSize - record.nameOffset)
+		{
+			return false;
+		}
+		cachedStars.emplace_back(record.id, record.x, record.y, std::string(stringPool + record.nameOffset, record.nameLength),
+								 sf::Color(record.colour[0], record.colour[1], record.colour[2], record.colour[3]));
+	}
+
+	if ((quadTree == nullptr) != (header->nodeCount == 0))
+	{
+		return false; // the key covers the index type, so this is a damaged file
+	}
+
+	// Children always come after their parent in the array, so checking the indices is enough to rule out cycles.
+	std::vector<GalaxyQuadTreeNode> nodes;
+	nodes.reserve(header->nodeCount);
+	for (uint32_t i = 0; i < header->nodeCount; ++i)
+	{
+		const NodeRecord &record = nodeRecords[i];
+		bool childrenValid = record.firstChild == GalaxyQuadTreeNode::NoChildren || (record.firstChild > i && header->nodeCount >= 4 && record.firstChild <= header->nodeCount - 4);
+		bool parentValid = i == 0 ? record.parent == GalaxyQuadTreeNode::NoParent : record.parent < i;
+		if (!childrenValid || !parentValid || record.firstStar > header->starCount || record.starCount > header->starCount - record.firstStar)
+		{
+			return false;
+		}
+		nodes.emplace_back(sf::FloatRect(record.left, record.top, record.width, record.height), record.parent, record.firstStar, record.starCount);
+		nodes.back().firstChild = record.firstChild;
+	}
+
+	// The indices alone still allow a node claimed by two parents, children outside their parent's star run, or a
+	// chain deeper than the fixed stack in GalaxyQuadTree::forEachStarInRange, so check each parent against its
+	// children too. Children come after their parent, so one pass in order sees every parent's depth first.
+	std::vector<int> depths(nodes.size(), 0);
+	for (uint32_t i = 0; i < nodes.size(); ++i)
+	{
+		const GalaxyQuadTreeNode &node = nodes[i];
+		for (int c = 0; c < 4 && !node.isLeaf(); ++c)
+		{
+			uint32_t childIndex = node.getChild(c);
+			const GalaxyQuadTreeNode &child = nodes[childIndex];
+			depths[childIndex] = depths[i] + 1;
+			bool insideParent = child.firstStar >= node.firstStar && child.firstStar + child.starCount <= node.firstStar + node.starCount;
+			if (child.parent != i || !insideParent || depths[childIndex] > GalaxyQuadTree::MaxSupportedDepth)
+			{
+				return false;
+			}
+		}
+	}
+
+	stars.swap(cachedStars);
+	if (quadTree != nullptr)
+	{
+		quadTree->assignNodes(nodes.data(), nodes.size());
+	}
+	return true;
+}
+
+void StarCatalogCache::save(const std::vector<Star> &stars, const GalaxyQuadTree *quadTree) const
+{
+	if (!usable)
+	{
+		return;
+	}
+
+	std::vector<StarRecord> starRecords;
+	std::string stringPool;
+	starRecords.reserve(stars.size());
+	for (const Star &star : stars)
+	{
+		std::string name = star.getName();
+		sf::Color colour = star.getColour();
+		StarRecord record;
+		record.id = star.getID();
+		record.x = star.getX();
+		record.y = star.getY();
+		record.nameOffset = static_cast<uint32_t>(stringPool.size());
+		record.nameLength = static_cast<uint32_t>(name.size());
+		record.colour[0] = colour.r;
+		record.colour[1] = colour.g;
+		record.colour[2] = colour.b;
+		record.colour[3] = colour.a;
+		starRecords.push_back(record);
+		stringPool += name;
+	}
+
+	std::vector<NodeRecord> nodeRecords;
+	const std::vector<GalaxyQuadTreeNode> noNodes;
+	const std::vector<GalaxyQuadTreeNode> &nodes = quadTree != nullptr ? quadTree->getNodes() : noNodes;
+	nodeRecords.reserve(nodes.size());
+	for (const GalaxyQuadTreeNode &node : nodes)
+	{
+		NodeRecord record;
+		record.left = node.boundary.left;
+		record.top = node.boundary.top;
+		record.width = node.boundary.width;
+		record.height = node.boundary.height;
+		record.firstChild = node.firstChild;
+		record.firstStar = node.firstStar;
+		record.starCount = node.starCount;
+		record.parent = node.parent;
+		nodeRecords.push_back(record);
+	}
+
+	CacheHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, CacheMagic, sizeof(CacheMagic));
+	header.version = CacheVersion;
+	header.byteOrderMark = ByteOrderMark;
+	header.key = key;
+	header.starCount = static_cast<uint32_t>(starRecords.size());
+	header.nodeCount = static_cast<uint32_t>(nodeRecords.size());
+	header.stringPoolSize = static_cast<uint32_t>(stringPool.size());
+
+	// Write next to the cache and rename over it, so a crash never leaves a half-written cache behind.
+	std::string temporaryPath = cachePath + ".tmp";
+	{
+		std::ofstream cacheFile(temporaryPath, std::ios::binary | std::ios::trunc);
+		cacheFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+		cacheFile.write(reinterpret_cast<const char *>(starRecords.data()), starRecords.size() * sizeof(StarRecord));
+		cacheFile.write(reinterpret_cast<const char *>(nodeRecords.data()), nodeRecords.size() * sizeof(NodeRecord));
+		cacheFile.write(stringPool.data(), stringPool.size());
+		if (!cacheFile)
+		{
+			std::cerr << "Error writing star catalog cache: " << temporaryPath << std::endl;
+			cacheFile.close();
+			std::remove(temporaryPath.c_str());
+			return;
+		}
+	}
+	std::remove(cachePath.c_str()); // rename does not replace an existing file on Windows
+	if (std::rename(temporaryPath.c_str(), cachePath.c_str()) != 0)
+	{
+		std::cerr << "Error writing star catalog cache: " << cachePath << std::endl;
+		std::remove(temporaryPath.c_str());
+	}
+}
@@ -0,0 +1,36 @@
+// StarCatalogCache.h
+#ifndef STARCATALOGCACHE_H
+#define STARCATALOGCACHE_H
+
+#include "GalaxyQuadTree.h"
+#include "LoadConfig.h"
+#include "Star.h"
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary copy of a loaded star catalog and its quadtree, so later runs can skip CSV parsing, projection, colour
+// mapping and tree building. The file is fixed-size star records plus a string pool for the names, followed by
+// the quadtree's node array. It is memory-mapped and read in place.
+//
+// The cache is keyed on a hash of the source file and of every setting that changes the result (scaleFactor,
+// window size, loadStarsLimit, spatialIndex, quadtreeSearchSize, quadtreeMaxDepth). A cache with any other key is ignored and rewritten.
+class StarCatalogCache
+{
+public:
+	StarCatalogCache(const std::string &sourcePath, const std::string &cachePath, const sf::Vector2u &mapSize, const LoadConfig &config);
+
+	bool isUsable() const; // false if the source could not be read, in which case load and save do nothing
+	// The quadtree's nodes are cached too. For the other spatial indexes quadTree is nullptr and only the stars,
+	// already in that index's order, are cached.
+	bool load(std::vector<Star> &stars, GalaxyQuadTree *quadTree) const; // true if a matching cache filled both
+	void save(const std::vector<Star> &stars, const GalaxyQuadTree *quadTree) const;
+
+private:
+	std::string cachePath;
+	uint64_t key;
+	bool usable;
+};
+
+#endif // STARCATALOGCACHE_H
@@ -0,0 +1,113 @@
+// StarRasterizer.cpp
+#include "StarRasterizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+	// Radii of the rim, core and centre discs, as the circles the star field used to be drawn with.
+	const float ToneRadii[3] = {3.5f, 3.0f, 2.5f};
+	const int ToneShift[3] = {-50, 0, 50}; // added to each channel of the star's colour
+
+	sf::Uint8 shiftChannel(sf::Uint8 channel, int shift)
+	{
+		return static_cast<sf::Uint8>(std::min(255, std::max(0, channel + shift)));
+	}
+}
+
+StarRasterizer::StarRasterizer() : stampRadius(static_cast<int>(std::ceil(ToneRadii[0])))
+{
+	// A pixel belongs to the smallest disc its centre falls inside, as when rasterising the circles.
+	for (int dy = -stampRadius; dy <= stampRadius; ++dy)
+	{
+		for (int dx = -stampRadius; dx <= stampRadius; ++dx)
+		{
+			float centreX = dx + 0.5f;
+			float centreY = dy + 0.5f;
+			float distanceSquared = centreX * centreX + centreY * centreY;
+			int tone = -1;
+			for (int candidate = 0; candidate < 3; ++candidate)
+			{
+				if (distanceSquared < ToneRadii[candidate] * ToneRadii[candidate])
+				{
+					tone = candidate;
+				}
+			}
+			if (tone >= 0)
+			{
+				stamp.push_back({dx, dy, tone});
+			}
+		}
+	}
+}
+
+int StarRasterizer::getStampRadius() const
+{
+	return stampRadius;
+}
+
+void StarRasterizer::rasterize(const std::vector<sf::Vertex> &points, const sf::Vector2f &origin, float scale, unsigned int width, unsigned int height, std::vector<sf::Uint8> &pixels) const
+{
+	pixels.assign(static_cast<size_t>(width) * height * 4, 0);
+	int imageWidth = static_cast<int>(width);
+	int imageHeight = static_cast<int>(height);
+
+	// Where each stamp pixel lands relative to the star's, as a byte offset into this image. Kept in locals: the
+	// pixel writes are through a byte pointer, which the compiler must otherwise assume could change the members.
+	std::vector<std::ptrdiff_t> offsets;
+	std::vector<int> stampTones;
+	for (const StampPixel &pixel : stamp)
+	{
+		offsets.push_back((static_cast<std::ptrdiff_t>(pixel.dy) * imageWidth + pixel.dx) * 4);
+		stampTones.push_back(pixel.tone);
+	}
+	const std::ptrdiff_t *offset = offsets.data();
+	const int *stampTone = stampTones.data();
+	const size_t stampSize = stamp.size();
+	const int radius = stampRadius;
+
+	for (const sf::Vertex &point : points)
+	{
+		// With scale a power of two and origin a multiple of the image size, neighbouring images agree on where a
+		// point falls, so a disc over their shared edge lines up.
+		int x = static_cast<int>(std::floor((point.position.x - origin.x) * scale));
+		int y = static_cast<int>(std::floor((point.position.y - origin.y) * scale));
+		if (x + radius < 0 || y + radius < 0 || x - radius >= imageWidth || y - radius >= imageHeight)
+		{
+			continue;
+		}
+
+		// Each tone as one RGBA pixel, so a stamp pixel is a single four byte copy.
+		const sf::Color &colour = point.color;
+		uint32_t tones[3];
+		for (int tone = 0; tone < 3; ++tone)
+		{
+			sf::Uint8 rgba[4] = {shiftChannel(colour.r, ToneShift[tone]), shiftChannel(colour.g, ToneShift[tone]), shiftChannel(colour.b, ToneShift[tone]), colour.a};
+			std::memcpy(&tones[tone], rgba, 4);
+		}
+
+		if (x >= radius && y >= radius && x + radius < imageWidth && y + radius < imageHeight)
+		{
+			sf::Uint8 *centre = pixels.data() + (static_cast<std::ptrdiff_t>(y) * imageWidth + x) * 4;
+			for (size_t i = 0; i < stampSize; ++i)
+			{
+				std::memcpy(centre + offset[i], &tones[stampTone[i]], 4);
+			}
+			continue;
+		}
+
+		// Near the edge, so some of the stamp falls outside the image, and so may the star's own pixel: each pixel
+		// kept is addressed from its own row and column, never from a pointer to the star's.
+		for (size_t i = 0; i < stampSize; ++i)
+		{
+			int pixelX = x + stamp[i].dx;
+			int pixelY = y + stamp[i].dy;
+			if (pixelX >= 0 && pixelY >= 0 && pixelX < imageWidth && pixelY < imageHeight)
+			{
+				std::memcpy(pixels.data() + (static_cast<std::ptrdiff_t>(pixelY) * imageWidth + pixelX) * 4, &tones[stampTone[i]], 4);
+			}
+		}
+	}
+}
@@ -0,0 +1,39 @@
+// StarRasterizer.h
+#ifndef STARRASTERIZER_H
+#define STARRASTERIZER_H
+
+#include <SFML/Graphics/Color.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <cstdint>
+#include <vector>
+
+// Draws stars straight into a pixel buffer, each as the same three-tone disc: a rim darker than the star's colour,
+// the colour itself, and a lighter centre. Every star sits on a whole pixel, so which tone each pixel around it
+// gets is worked out once, and drawing a star is just copying its three colours through that stamp. Far cheaper
+// than drawing shapes through the GPU one star at a time, for the same picture. Discs are the same size in pixels
+// at any scale, so zooming in spreads stars apart rather than enlarging them.
+class StarRasterizer
+{
+public:
+	StarRasterizer();
+
+	// Fills pixels (RGBA, top row first, width x height) with a disc for each point, in order, later ones on top.
+	// Point positions are map coordinates; the image's top left is origin, and scale is pixels per map unit.
+	// Anything not covered by a disc is left transparent.
+	void rasterize(const std::vector<sf::Vertex> &points, const sf::Vector2f &origin, float scale, unsigned int width, unsigned int height, std::vector<sf::Uint8> &pixels) const;
+	int getStampRadius() const; // how far, in pixels, a disc reaches from its point
+
+private:
+	struct StampPixel
+	{
+		int dx; // offset from the star's pixel
+		int dy;
+		int tone; // 0 rim, 1 core, 2 centre
+	};
+
+	std::vector<StampPixel> stamp; // the pixels a star covers, each with the one tone it gets
+	int stampRadius;			   // every stamp pixel is within this many pixels of the star's in x and y
+};
+
+#endif // STARRASTERIZER_H
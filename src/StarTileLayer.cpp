@@ -0,0 +1,237 @@
+// StarTileLayer.cpp
+#include "StarTileLayer.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace
+{
+	const size_t MaxCachedTiles = 256;		// 64MB of textures; more are kept only while one frame needs them all
+	const sf::Time TileBuildTimePerFrame = sf::milliseconds(8); // tiles left over wait for later frames, so a zoom never stalls on a whole screen
+	const float AggregatePixels = 4.0f;		// zoomed out, quadtree nodes no wider than this on screen are drawn as one point
+
+	int floorShift(int value, int shift) // value / 2^shift, rounded down for negative values too
+	{
+		return value >= 0 ? value >> shift : -((-value - 1) >> shift) - 1;
+	}
+
+	// A pale point that brightens with the number of stars it stands for.
+	sf::Color aggregateColour(uint32_t starCount)
+	{
+		int brightness = std::min(255, 96 + static_cast<int>(24.0f * std::log2(static_cast<float>(starCount))));
+		return sf::Color(static_cast<sf::Uint8>(brightness), static_cast<sf::Uint8>(brightness), static_cast<sf::Uint8>(std::min(255, brightness + 24)));
+	}
+}
+
+StarTileLayer::StarTileLayer() : index(nullptr),
+								 quadTree(nullptr),
+								 frame(0)
+{
+}
+
+void StarTileLayer::setStars(const SpatialIndex &index, const GalaxyQuadTree *quadTree, const sf::FloatRect &mapBoundary)
+{
+	this->index = &index;
+	this->quadTree = quadTree;
+	this->mapBoundary = mapBoundary;
+	tiles.clear();
+	tileMap.clear();
+}
+
+void StarTileLayer::draw(sf::RenderTarget &target)
+{
+	// A frame that needed more than MaxCachedTiles grew the cache past it. Trim it back to tiles the last frame drew,
+	// so a view that still needs them all keeps them.
+	while (tiles.size() > MaxCachedTiles && tiles.back().lastUsed != frame)
+	{
+		tileMap.erase(tiles.back().key);
+		tiles.pop_back();
+	}
+	++frame;
+	if (!index)
+	{
+		return;
+	}
+
+	// The level whose tile pixels are nearest in size to the target's pixels.
+	const sf::View &view = target.getView();
+	float pixelsPerUnit = target.getSize().x * view.getViewport().width / view.getSize().x;
+	int level = std::min(MaxLevel, std::max(MinLevel, static_cast<int>(std::lround(std::log2(pixelsPerUnit)))));
+	float scale = std::ldexp(1.0f, level);
+	float tileMapSize = TileSize / scale;
+
+	// Only tiles over the map are ever needed, but stars on its edge reach a little way out.
+	float margin = (rasterizer.getStampRadius() + 1) / scale;
+	float left = std::max(view.getCenter().x - view.getSize().x / 2, mapBoundary.left - margin);
+	float right = std::min(view.getCenter().x + view.getSize().x / 2, mapBoundary.left + mapBoundary.width + margin);
+	float top = std::max(view.getCenter().y - view.getSize().y / 2, mapBoundary.top - margin);
+	float bottom = std::min(view.getCenter().y + view.getSize().y / 2, mapBoundary.top + mapBoundary.height + margin);
+	if (left >= right || top >= bottom)
+	{
+		return;
+	}
+
+	sf::Clock buildClock;
+	bool built = false;
+	for (int y = static_cast<int>(std::floor(top / tileMapSize)); y <= static_cast<int>(std::floor(bottom / tileMapSize)); ++y)
+	{
+		for (int x = static_cast<int>(std::floor(left / tileMapSize)); x <= static_cast<int>(std::floor(right / tileMapSize)); ++x)
+		{
+			Tile *tile = findTile(level, x, y);
+			if (!tile && (!built || buildClock.getElapsedTime() < TileBuildTimePerFrame))
+			{
+				tile = &buildTile(level, x, y); // at least one a frame, however slow
+				built = true;
+			}
+			if (tile)
+			{
+				drawTile(target, *tile, level, x, y, sf::IntRect(0, 0, TileSize, TileSize));
+				continue;
+			}
+
+			// Not built yet: until it is, stretch the matching part of the nearest coarser tile already cached over it.
+			for (int coarser = level - 1; coarser >= MinLevel && (TileSize >> (level - coarser)) > 0; --coarser)
+			{
+				int shift = level - coarser;
+				int parentX = floorShift(x, shift);
+				int parentY = floorShift(y, shift);
+				if (Tile *parent = findTile(coarser, parentX, parentY))
+				{
+					int partSize = TileSize >> shift;
+					sf::IntRect part((x - (parentX << shift)) * partSize, (y - (parentY << shift)) * partSize, partSize, partSize);
+					drawTile(target, *parent, coarser, parentX, parentY, part);
+					break;
+				}
+			}
+		}
+	}
+}
+
+uint64_t StarTileLayer::tileKey(int level, int x, int y)
+{
+	return (static_cast<uint64_t>(static_cast<uint8_t>(level)) << 56) | (static_cast<uint64_t>(static_cast<uint32_t>(x) & 0xFFFFFFF) << 28) |
+		   (static_cast<uint32_t>(y) & 0xFFFFFFF);
+}
+
+StarTileLayer::Tile *StarTileLayer::findTile(int level, int x, int y)
+{
+	auto found = tileMap.find(tileKey(level, x, y));
+	if (found == tileMap.end())
+	{
+		return nullptr;
+	}
+	tiles.splice(tiles.begin(), tiles, found->second);
+	found->second->lastUsed = frame;
+	return &*found->second;
+}
+
+StarTileLayer::Tile &StarTileLayer::buildTile(int level, int x, int y)
+{
+	// Once the cache is full, the least recently drawn tile (unless it is still on screen) is reused, texture and all.
+	if (tiles.size() >= MaxCachedTiles && tiles.back().lastUsed != frame)
+	{
+		tileMap.erase(tiles.back().key);
+		tiles.splice(tiles.begin(), tiles, std::prev(tiles.end()));
+	}
+	else
+	{
+		tiles.emplace_front();
+	}
+	Tile &tile = tiles.front();
+	tile.key = tileKey(level, x, y);
+	tile.lastUsed = frame;
+	tileMap[tile.key] = tiles.begin();
+
+	// Everything whose disc could reach into the tile, including from just over its edges.
+	float scale = std::ldexp(1.0f, level);
+	float tileMapSize = TileSize / scale;
+	float margin = (rasterizer.getStampRadius() + 1) / scale;
+	sf::Vector2f origin(x * tileMapSize, y * tileMapSize);
+	collectPoints(level, sf::FloatRect(origin.x - margin, origin.y - margin, tileMapSize + 2 * margin, tileMapSize + 2 * margin));
+	tile.empty = points.empty();
+	if (tile.empty)
+	{
+		return tile;
+	}
+
+	rasterizer.rasterize(points, origin, scale, TileSize, TileSize, pixels);
+	if (tile.texture.getSize() != sf::Vector2u(TileSize, TileSize))
+	{
+		tile.texture.create(TileSize, TileSize);
+		tile.texture.setSmooth(true); // views between two levels scale the tiles a little
+	}
+	tile.texture.update(pixels.data());
+	return tile;
+}
+
+void StarTileLayer::collectPoints(int level, const sf::FloatRect &area)
+{
+	points.clear();
+	const std::vector<Star> &stars = index->getStars();
+	if (!quadTree || level >= 0)
+	{
+		// Star by star, in table order, so overlapping discs stack up the same way in every tile they cross.
+		index->findInRect(area, starIndices);
+		std::sort(starIndices.begin(), starIndices.end());
+		for (uint32_t starIndex : starIndices)
+		{
+			const Star &star = stars[starIndex];
+			points.push_back(sf::Vertex(sf::Vector2f(static_cast<float>(star.getX()), static_cast<float>(star.getY())), star.getColour()));
+		}
+		return;
+	}
+
+	// Zoomed out, walk the tree in a fixed order (the same for every tile), stopping at nodes too small to show
+	// more than one point. A node's stars left out of all four children are drawn before the children.
+	float scale = std::ldexp(1.0f, level);
+	const std::vector<GalaxyQuadTreeNode> &nodes = quadTree->getNodes();
+	nodeStack.assign(1, 0);
+	while (!nodeStack.empty())
+	{
+		const GalaxyQuadTreeNode &node = nodes[nodeStack.back()];
+		nodeStack.pop_back();
+		if (node.starCount == 0 || !area.intersects(node.boundary))
+		{
+			continue;
+		}
+		if (node.starCount > 1 && node.boundary.width * scale <= AggregatePixels)
+		{
+			sf::Vector2f centre(node.boundary.left + node.boundary.width / 2, node.boundary.top + node.boundary.height / 2);
+			points.push_back(sf::Vertex(centre, aggregateColour(node.starCount)));
+			continue;
+		}
+
+		uint32_t firstStar = node.firstStar;
+		if (!node.isLeaf())
+		{
+			const GalaxyQuadTreeNode &lastChild = nodes[node.getChild(3)]; // SE comes last in Z-order
+			firstStar = lastChild.firstStar + lastChild.starCount;
+			for (int i = 3; i >= 0; --i)
+			{
+				nodeStack.push_back(node.getChild(i));
+			}
+		}
+		for (uint32_t starIndex = firstStar; starIndex < node.firstStar + node.starCount; ++starIndex)
+		{
+			const Star &star = stars[starIndex];
+			if (area.contains(static_cast<float>(star.getX()), static_cast<float>(star.getY())))
+			{
+				points.push_back(sf::Vertex(sf::Vector2f(static_cast<float>(star.getX()), static_cast<float>(star.getY())), star.getColour()));
+			}
+		}
+	}
+}
+
+void StarTileLayer::drawTile(sf::RenderTarget &target, const Tile &tile, int level, int x, int y, const sf::IntRect &part)
+{
+	if (tile.empty)
+	{
+		return;
+	}
+	// part is in the tile's pixels; placed and scaled into map coordinates.
+	float unitsPerPixel = std::ldexp(1.0f, -level);
+	sf::Sprite sprite(tile.texture, part);
+	sprite.setPosition((x * TileSize + part.left) * unitsPerPixel, (y * TileSize + part.top) * unitsPerPixel);
+	sprite.setScale(unitsPerPixel, unitsPerPixel);
+	target.draw(sprite);
+}
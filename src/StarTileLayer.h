@@ -0,0 +1,62 @@
+// StarTileLayer.h
+#ifndef STARTILELAYER_H
+#define STARTILELAYER_H
+
+#include "GalaxyQuadTree.h"
+#include "SpatialIndex.h"
+#include "StarRasterizer.h"
+#include <SFML/Graphics.hpp>
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// The star field as a pyramid of pre-rendered square tiles, one set per zoom level, so any view is drawn from a
+// handful of textures rather than by rasterising the stars again. Level 0 is one tile pixel per map unit, and each
+// level up doubles that. Tiles are rasterised the first time a view needs them and kept in a cache that drops the
+// least recently drawn. Below level 0 stars crowd together, so quadtree nodes too small to tell apart on screen are
+// drawn as a single point rather than star by star.
+class StarTileLayer
+{
+public:
+	static constexpr int MinLevel = -5;	 // the most zoomed out: 32 map units to a pixel
+	static constexpr int MaxLevel = 5;	 // the most zoomed in: 32 pixels to a map unit
+	static constexpr int TileSize = 256; // pixels along a tile's side
+
+	StarTileLayer();
+
+	// Draw the stars found through index (with quadTree, if there is one, for zoomed out levels). The cache is
+	// emptied; both must outlive the layer or the next call.
+	void setStars(const SpatialIndex &index, const GalaxyQuadTree *quadTree, const sf::FloatRect &mapBoundary);
+	void draw(sf::RenderTarget &target); // the tiles covering the target's view, at the level nearest its zoom
+
+private:
+	struct Tile
+	{
+		uint64_t key;	   // tileKey
+		sf::Texture texture;
+		bool empty;		   // no star reaches the tile, so there is no texture to draw
+		uint64_t lastUsed; // frame the tile was last drawn in
+	};
+
+	static uint64_t tileKey(int level, int x, int y);
+	Tile *findTile(int level, int x, int y); // cached tile, now the most recently used, or nullptr
+	Tile &buildTile(int level, int x, int y);
+	void collectPoints(int level, const sf::FloatRect &area); // fill points with what to draw over area at level
+	void drawTile(sf::RenderTarget &target, const Tile &tile, int level, int x, int y, const sf::IntRect &part);
+
+	StarRasterizer rasterizer;
+	const SpatialIndex *index;
+	const GalaxyQuadTree *quadTree;
+	sf::FloatRect mapBoundary;
+	std::list<Tile> tiles;										 // most recently used first
+	std::unordered_map<uint64_t, std::list<Tile>::iterator> tileMap; // tileKey to its entry in tiles
+	uint64_t frame;
+	// Scratch space for building tiles, kept between them
+	std::vector<uint32_t> starIndices;
+	std::vector<uint32_t> nodeStack;
+	std::vector<sf::Vertex> points;
+	std::vector<sf::Uint8> pixels;
+};
+
+#endif // STARTILELAYER_H
@@ -0,0 +1,112 @@
+// ThreadPool.cpp
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount) : currentTask(nullptr),
+												   itemCount(0),
+												   chunkSize(1),
+												   nextItem(0),
+												   busyWorkers(0),
+												   generation(0),
+												   stopping(false)
+{
+	if (threadCount == 0)
+	{
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	// The calling thread is one of the threads, so start one fewer workers.
+	for (unsigned int i = 1; i < threadCount; ++i)
+	{
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+	for (std::thread &worker : workers)
+	{
+		worker.join();
+	}
+}
+
+unsigned int ThreadPool::getThreadCount() const
+{
+	return static_cast<unsigned int>(workers.size()) + 1;
+}
+
+void ThreadPool::parallelFor(size_t count, const RangeTask &task)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (workers.empty() || count == 1)
+	{
+		task(0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentTask = &task;
+		itemCount = count;
+		// A few chunks per thread keeps everyone busy when some items (long searches) cost more than others.
+		chunkSize = std::max<size_t>(1, count / (getThreadCount() * 4));
+		nextItem.store(0);
+		busyWorkers = static_cast<unsigned int>(workers.size());
+		generation++;
+	}
+	workAvailable.notify_all();
+
+	runChunks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	workFinished.wait(lock, [this]()
+					  { return busyWorkers == 0; });
+	currentTask = nullptr;
+}
+
+void ThreadPool::workerLoop()
+{
+	unsigned long long seenGeneration = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workAvailable.wait(lock, [this, seenGeneration]()
+							   { return stopping || generation != seenGeneration; });
+			if (stopping)
+			{
+				return;
+			}
+			seenGeneration = generation;
+		}
+
+		runChunks();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+		}
+		workFinished.notify_one();
+	}
+}
+
+void ThreadPool::runChunks()
+{
+	while (true)
+	{
+		size_t begin = nextItem.fetch_add(chunkSize);
+		if (begin >= itemCount)
+		{
+			return;
+		}
+		(*currentTask)(begin, std::min(begin + chunkSize, itemCount));
+	}
+}
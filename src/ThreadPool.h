@@ -0,0 +1,47 @@
+// ThreadPool.h
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for data-parallel loops. The calling thread also takes part in each loop.
+// With a thread count of 1 no workers are started and parallelFor simply runs the task inline.
+class ThreadPool
+{
+public:
+	typedef std::function<void(size_t begin, size_t end)> RangeTask; // process items [begin, end)
+
+	explicit ThreadPool(unsigned int threadCount); // 0 means one thread per hardware core
+	~ThreadPool();
+
+	void parallelFor(size_t count, const RangeTask &task); // returns once every item has been processed
+	unsigned int getThreadCount() const;
+
+private:
+	void workerLoop();
+	void runChunks();
+
+	std::vector<std::thread> workers;
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::condition_variable workFinished;
+	const RangeTask *currentTask;
+	size_t itemCount;
+	size_t chunkSize;
+	std::atomic<size_t> nextItem;
+	unsigned int busyWorkers;
+	unsigned long long generation; // bumped for every parallelFor so workers know there is new work
+	bool stopping;
+
+	// Thread pools own their threads, so they cannot be copied
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+};
+
+#endif // THREADPOOL_H
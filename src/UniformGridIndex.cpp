@@ -0,0 +1,242 @@
+// UniformGridIndex.cpp
+#include "UniformGridIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace
+{
+	const int MaxCellsPerAxis = 4096;
+}
+
+UniformGridIndex::UniformGridIndex(const sf::FloatRect &boundary, int bucketSize, std::vector<Star> &starTable) : SpatialIndex(starTable),
+																												 boundary(boundary),
+																												 bucketSize(std::max(1, bucketSize)),
+																												 columns(1),
+																												 rows(1),
+																												 cellWidth(boundary.width),
+																												 cellHeight(boundary.height)
+{
+}
+
+void UniformGridIndex::build(ThreadPool &threadPool)
+{
+	uint32_t starCount = static_cast<uint32_t>(starTable.size());
+	uint32_t insideCount = 0;
+	for (const Star &star : starTable)
+	{
+		insideCount += boundary.contains(star.getX(), star.getY()) ? 1 : 0;
+	}
+
+	// Aim for bucketSize stars per cell on average, with cells as square as the map allows.
+	double targetCells = std::max(1.0, static_cast<double>(insideCount) / bucketSize);
+	columns = static_cast<int>(std::lround(std::sqrt(targetCells * boundary.width / boundary.height)));
+	columns = std::min(std::max(columns, 1), MaxCellsPerAxis);
+	rows = static_cast<int>(std::ceil(targetCells / columns));
+	rows = std::min(std::max(rows, 1), MaxCellsPerAxis);
+	cellWidth = boundary.width / columns;
+	cellHeight = boundary.height / rows;
+	uint32_t cellCount = static_cast<uint32_t>(columns) * static_cast<uint32_t>(rows);
+
+	// Stars outside the map go in an extra bucket at the end, kept in the table but not indexed.
+	std::vector<uint32_t> starCells(starCount);
+	threadPool.parallelFor(starCount, [&](size_t begin, size_t end)
+						   {
+		for (size_t i = begin; i < end; ++i)
+		{
+			const Star &star = starTable[i];
+			bool inside = boundary.contains(star.getX(), star.getY());
+			starCells[i] = inside ? static_cast<uint32_t>(getRow(star.getY())) * columns + getColumn(star.getX()) : cellCount;
+		} });
+
+	// Counting sort by cell. It is stable, so sorting a table that is already in cell order changes nothing.
+	cellStarts.assign(cellCount + 2, 0);
+	for (uint32_t cell : starCells)
+	{
+		cellStarts[cell + 1]++;
+	}
+	for (uint32_t cell = 0; cell <= cellCount; ++cell)
+	{
+		cellStarts[cell + 1] += cellStarts[cell];
+	}
+	std::vector<uint32_t> order(starCount);
+	std::vector<uint32_t> nextSlot(cellStarts.begin(), cellStarts.end() - 1);
+	for (uint32_t starIndex = 0; starIndex < starCount; ++starIndex)
+	{
+		order[nextSlot[starCells[starIndex]]++] = starIndex;
+	}
+	std::vector<Star> sortedStars;
+	sortedStars.reserve(starCount);
+	for (uint32_t starIndex : order)
+	{
+		sortedStars.push_back(std::move(starTable[starIndex]));
+	}
+	starTable.swap(sortedStars);
+	cellStarts.pop_back(); // the outside bucket's end
+
+	availableStarCounts = std::vector<std::atomic<uint32_t>>(cellCount);
+	for (uint32_t cell = 0; cell < cellCount; ++cell)
+	{
+		uint32_t available = 0;
+		for (uint32_t starIndex = cellStarts[cell]; starIndex < cellStarts[cell + 1]; ++starIndex)
+		{
+			available += starTable[starIndex].getIsAvailable() ? 1 : 0;
+		}
+		availableStarCounts[cell].store(available, std::memory_order_relaxed);
+	}
+}
+
+int UniformGridIndex::getColumn(float x) const
+{
+	int column = static_cast<int>(std::floor((x - boundary.left) / cellWidth));
+	return std::min(std::max(column, 0), columns - 1);
+}
+
+int UniformGridIndex::getRow(float y) const
+{
+	int row = static_cast<int>(std::floor((y - boundary.top) / cellHeight));
+	return std::min(std::max(row, 0), rows - 1);
+}
+
+sf::FloatRect UniformGridIndex::getCellBoundary(int column, int row) const
+{
+	return sf::FloatRect(boundary.left + column * cellWidth, boundary.top + row * cellHeight, cellWidth, cellHeight);
+}
+
+void UniformGridIndex::availableStarCountChanged(uint32_t starIndex, int delta)
+{
+	size_t cell = std::upper_bound(cellStarts.begin(), cellStarts.end(), starIndex) - cellStarts.begin() - 1;
+	if (cell < availableStarCounts.size())
+	{
+		availableStarCounts[cell].fetch_add(static_cast<uint32_t>(delta), std::memory_order_relaxed);
+	}
+}
+
+void UniformGridIndex::scanCell(int column, int row, const sf::Vector2f &point, const StarFilter &filter, bool availableOnly, NearestCandidates &candidates) const
+{
+	uint32_t cell = static_cast<uint32_t>(row) * columns + column;
+	if ((availableOnly && availableStarCounts[cell].load(std::memory_order_relaxed) == 0) || distanceSquaredToRect(point, getCellBoundary(column, row)) > candidates.getBound())
+	{
+		return;
+	}
+	for (uint32_t starIndex = cellStarts[cell]; starIndex < cellStarts[cell + 1]; ++starIndex)
+	{
+		const Star &star = starTable[starIndex];
+		if (availableOnly && !star.getIsAvailable())
+		{
+			continue;
+		}
+		float dx = star.getX() - point.x;
+		float dy = star.getY() - point.y;
+		float distanceSquared = dx * dx + dy * dy;
+		if (distanceSquared <= candidates.getBound() && filter(starIndex))
+		{
+			candidates.offer(distanceSquared, starIndex);
+		}
+	}
+}
+
+void UniformGridIndex::searchNearest(const sf::Vector2f &point, size_t k, const StarFilter &filter, std::vector<uint32_t> &results, float maxDistance, uint32_t, bool availableOnly) const
+{
+	results.clear();
+	if (k == 0 || cellStarts.empty())
+	{
+		return;
+	}
+
+	static thread_local NearestCandidates candidates;
+	candidates.reset(k, maxDistance * maxDistance);
+	const float infinity = std::numeric_limits<float>::infinity();
+	int centerColumn = getColumn(point.x);
+	int centerRow = getRow(point.y);
+	for (int ring = 0;; ++ring)
+	{
+		if (ring > 0)
+		{
+			// Every later ring lies outside the block of cells already searched, so stop once the block's nearest
+			// edge is further away than anything that could still get in. Sides on the edge of the grid have nothing beyond.
+			int firstColumn = centerColumn - ring + 1;
+			int lastColumn = centerColumn + ring - 1;
+			int firstRow = centerRow - ring + 1;
+			int lastRow = centerRow + ring - 1;
+			float leftGap = firstColumn <= 0 ? infinity : point.x - (boundary.left + firstColumn * cellWidth);
+			float rightGap = lastColumn >= columns - 1 ? infinity : boundary.left + (lastColumn + 1) * cellWidth - point.x;
+			float topGap = firstRow <= 0 ? infinity : point.y - (boundary.top + firstRow * cellHeight);
+			float bottomGap = lastRow >= rows - 1 ? infinity : boundary.top + (lastRow + 1) * cellHeight - point.y;
+			float edgeDistance = std::max(0.0f, std::min(std::min(leftGap, rightGap), std::min(topGap, bottomGap)));
+			if (edgeDistance == infinity || edgeDistance * edgeDistance > candidates.getBound())
+			{
+				break;
+			}
+		}
+
+		for (int row = std::max(centerRow - ring, 0); row <= std::min(centerRow + ring, rows - 1); ++row)
+		{
+			bool edgeRow = row == centerRow - ring || row == centerRow + ring;
+			int columnStep = edgeRow ? 1 : 2 * ring; // rows in between only touch the ring at its two ends
+			for (int column = centerColumn - ring; column <= centerColumn + ring; column += std::max(columnStep, 1))
+			{
+				if (column >= 0 && column < columns)
+				{
+					scanCell(column, row, point, filter, availableOnly, candidates);
+				}
+			}
+		}
+	}
+	candidates.copyTo(results);
+}
+
+void UniformGridIndex::findInRadius(const sf::Vector2f &center, float radius, std::vector<uint32_t> &results) const
+{
+	results.clear();
+	if (cellStarts.empty())
+	{
+		return;
+	}
+	float radiusSquared = radius * radius;
+	for (int row = getRow(center.y - radius); row <= getRow(center.y + radius); ++row)
+	{
+		for (int column = getColumn(center.x - radius); column <= getColumn(center.x + radius); ++column)
+		{
+			uint32_t cell = static_cast<uint32_t>(row) * columns + column;
+			for (uint32_t starIndex = cellStarts[cell]; starIndex < cellStarts[cell + 1]; ++starIndex)
+			{
+				float dx = starTable[starIndex].getX() - center.x;
+				float dy = starTable[starIndex].getY() - center.y;
+				if (dx * dx + dy * dy <= radiusSquared)
+				{
+					results.push_back(starIndex);
+				}
+			}
+		}
+	}
+}
+
+void UniformGridIndex::findInRect(const sf::FloatRect &rect, std::vector<uint32_t> &results) const
+{
+	results.clear();
+	if (cellStarts.empty())
+	{
+		return;
+	}
+	// Like contains, rect may have a negative size.
+	int firstRow = getRow(std::min(rect.top, rect.top + rect.height));
+	int lastRow = getRow(std::max(rect.top, rect.top + rect.height));
+	int firstColumn = getColumn(std::min(rect.left, rect.left + rect.width));
+	int lastColumn = getColumn(std::max(rect.left, rect.left + rect.width));
+	for (int row = firstRow; row <= lastRow; ++row)
+	{
+		for (int column = firstColumn; column <= lastColumn; ++column)
+		{
+			uint32_t cell = static_cast<uint32_t>(row) * columns + column;
+			for (uint32_t starIndex = cellStarts[cell]; starIndex < cellStarts[cell + 1]; ++starIndex)
+			{
+				if (rect.contains(starTable[starIndex].getX(), starTable[starIndex].getY()))
+				{
+					results.push_back(starIndex);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,43 @@
+// UniformGridIndex.h
+#ifndef UNIFORMGRIDINDEX_H
+#define UNIFORMGRIDINDEX_H
+
+#include "SpatialIndex.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Spatial index "grid": the map cut into equal cells sized to hold about bucketSize stars each on average. The star
+// table is sorted by cell, so each cell is one run of it. Cheap to build and to query when stars are spread evenly;
+// dense clusters end up in a few very full cells.
+class UniformGridIndex : public SpatialIndex
+{
+public:
+	UniformGridIndex(const sf::FloatRect &boundary, int bucketSize, std::vector<Star> &starTable);
+
+	void build(ThreadPool &threadPool) override;
+	void findInRadius(const sf::Vector2f &center, float radius, std::vector<uint32_t> &results) const override;
+	void findInRect(const sf::FloatRect &rect, std::vector<uint32_t> &results) const override;
+
+protected:
+	// Searches ring by ring outwards from the cell holding point, until no ring can hold anything closer.
+	void searchNearest(const sf::Vector2f &point, size_t k, const StarFilter &filter, std::vector<uint32_t> &results, float maxDistance, uint32_t hint, bool availableOnly) const override;
+	void availableStarCountChanged(uint32_t starIndex, int delta) override;
+
+private:
+	int getColumn(float x) const; // clamped to the grid
+	int getRow(float y) const;
+	sf::FloatRect getCellBoundary(int column, int row) const;
+	void scanCell(int column, int row, const sf::Vector2f &point, const StarFilter &filter, bool availableOnly, NearestCandidates &candidates) const;
+
+	sf::FloatRect boundary;
+	int bucketSize;
+	int columns;
+	int rows;
+	float cellWidth;
+	float cellHeight;
+	std::vector<uint32_t> cellStarts;						// cell c holds stars [cellStarts[c], cellStarts[c + 1]), cells row by row
+	std::vector<std::atomic<uint32_t>> availableStarCounts; // per cell
+};
+
+#endif // UNIFORMGRIDINDEX_H
@@ -0,0 +1,124 @@
+// VisitedStarHistory.cpp
+#include "VisitedStarHistory.h"
+#include <atomic>
+
+namespace
+{
+	std::atomic<uint32_t> nextOwnerID(0);
+}
+
+VisitedStarHistory::VisitedStarHistory() : head(std::make_shared<Segment>()),
+										   ownerID(nextOwnerID.fetch_add(1, std::memory_order_relaxed))
+{
+	head->parentSize = 0;
+	head->ownerID = ownerID;
+}
+
+VisitedStarHistory::VisitedStarHistory(const VisitedStarHistory &other) : head(std::make_shared<Segment>(*other.head)),
+																		  ownerID(other.ownerID)
+{
+}
+
+VisitedStarHistory &VisitedStarHistory::operator=(const VisitedStarHistory &other)
+{
+	if (this != &other)
+	{
+		head = std::make_shared<Segment>(*other.head);
+		ownerID = other.ownerID;
+	}
+	return *this;
+}
+
+void VisitedStarHistory::add(uint32_t starID, const sf::Vector2f &coordinates, bool visitedByProbe)
+{
+	VisitedStarSystem visitedSystem = {starID, coordinates, visitedByProbe};
+	head->entries.push_back(visitedSystem);
+	head->stars.insert(starID);
+}
+
+VisitedStarHistory VisitedStarHistory::inherit()
+{
+	// Freeze what has been recorded so far. An empty head adds nothing, so it is kept and its parent is shared instead.
+	std::shared_ptr<const Segment> frozen = head->parent;
+	size_t frozenSize = head->parentSize;
+	if (!head->entries.empty())
+	{
+		frozen = head;
+		frozenSize = size();
+
+		head = std::make_shared<Segment>();
+		head->parent = frozen;
+		head->parentSize = frozenSize;
+		head->ownerID = ownerID;
+	}
+
+	VisitedStarHistory child;
+	child.head->parent = frozen;
+	child.head->parentSize = frozenSize;
+	return child;
+}
+
+bool VisitedStarHistory::contains(uint32_t starID) const
+{
+	for (const Segment *segment = head.get(); segment != nullptr; segment = segment->parent.get())
+	{
+		if (segment->stars.contains(starID))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+size_t VisitedStarHistory::size() const
+{
+	return head->parentSize + head->entries.size();
+}
+
+bool VisitedStarHistory::empty() const
+{
+	return size() == 0;
+}
+
+void VisitedStarHistory::forEach(const Visitor &visit) const
+{
+	forEachSince(0, visit);
+}
+
+void VisitedStarHistory::forEachSince(size_t first, const Visitor &visit) const
+{
+	// Collect the segments holding entries from first on, newest first, then walk them oldest first. A loop rather
+	// than recursion, so deep lineages cannot run out of stack. The list is per-thread scratch that keeps its capacity
+	// between calls; this call only uses it above base, so a visitor may call forEachSince again.
+	static thread_local std::vector<const Segment *> segments;
+	const size_t base = segments.size();
+	for (const Segment *segment = head.get(); segment != nullptr; segment = segment->parent.get())
+	{
+		segments.push_back(segment);
+		if (first >= segment->parentSize)
+		{
+			break;
+		}
+	}
+
+	for (size_t index = segments.size(); index-- > base;)
+	{
+		const Segment &segment = *segments[index];
+		for (size_t i = first > segment.parentSize ? first - segment.parentSize : 0; i < segment.entries.size(); ++i)
+		{
+			const VisitedStarSystem &visitedSystem = segment.entries[i];
+			if (segment.ownerID == ownerID)
+			{
+				visit(visitedSystem);
+			}
+			else
+			{
+				// Recorded by an ancestor, so from this probe's point of view it was visited by a parent.
+				VisitedStarSystem inherited = visitedSystem;
+				inherited.visitedByProbe = false;
+				visit(inherited);
+			}
+		}
+	}
+	segments.resize(base);
+}
@@ -0,0 +1,60 @@
+// VisitedStarHistory.h
+#ifndef VISITEDSTARHISTORY_H
+#define VISITEDSTARHISTORY_H
+
+#include "VisitedStarSet.h"
+#include <SFML/System/Vector2.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct VisitedStarSystem // Probes own private memory of visited systems.
+{
+	// std::string systemName;
+	uint32_t starID;
+	sf::Vector2f coordinates; // Coordinates of the star system
+	bool visitedByProbe;	  // Indicator to differentiate direct visitation by probe (true) or parent (false)
+};
+
+// A probe's ordered trail of visited star systems, shared structurally with its ancestors.
+// The trail is a chain of segments: the newest (head) segment belongs to this probe and is appended to,
+// older segments are frozen and may be shared by any number of descendants. Replicating a probe freezes
+// the parent's head and starts a fresh head on each side, so a child inherits the entries without copying them.
+// Each segment also keeps a set of its own entries' stars, frozen with it, so contains is one lookup per segment
+// in the chain and replication copies nothing.
+class VisitedStarHistory
+{
+public:
+	typedef std::function<void(const VisitedStarSystem &)> Visitor;
+
+	VisitedStarHistory();
+	VisitedStarHistory(const VisitedStarHistory &other); // copies get their own head segment, the frozen chain stays shared
+	VisitedStarHistory(VisitedStarHistory &&other) = default; // moves take the head over; the moved-from history may only be assigned or destroyed
+	VisitedStarHistory &operator=(const VisitedStarHistory &other);
+	VisitedStarHistory &operator=(VisitedStarHistory &&other) = default;
+
+	void add(uint32_t starID, const sf::Vector2f &coordinates, bool visitedByProbe);
+	VisitedStarHistory inherit(); // history for a child probe; freezes everything recorded so far
+	bool contains(uint32_t starID) const;
+	size_t size() const;
+	bool empty() const;
+	void forEach(const Visitor &visit) const; // oldest first; entries recorded by an ancestor report visitedByProbe as false
+	void forEachSince(size_t first, const Visitor &visit) const; // as forEach, but only entries [first, size())
+
+private:
+	struct Segment
+	{
+		std::vector<VisitedStarSystem> entries;
+		VisitedStarSet stars;					 // IDs of entries
+		std::shared_ptr<const Segment> parent; // older, frozen history
+		size_t parentSize;						 // number of entries in the parent chain
+		uint32_t ownerID;						 // the probe history that recorded these entries
+	};
+
+	std::shared_ptr<Segment> head;
+	uint32_t ownerID;
+};
+
+#endif // VISITEDSTARHISTORY_H
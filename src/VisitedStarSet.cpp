@@ -0,0 +1,96 @@
+// VisitedStarSet.cpp
+#include "VisitedStarSet.h"
+
+VisitedStarSet::VisitedStarSet() : count(0),
+								   containsEmptySlotID(false)
+{
+}
+
+bool VisitedStarSet::insert(uint32_t starID)
+{
+	if (starID == EmptySlot)
+	{
+		bool added = !containsEmptySlotID;
+		containsEmptySlotID = true;
+		return added;
+	}
+
+	if ((count + 1) * 2 > slots.size())
+	{
+		grow();
+	}
+
+	size_t mask = slots.size() - 1;
+	for (size_t slot = slotFor(starID);; slot = (slot + 1) & mask)
+	{
+		if (slots[slot] == starID)
+		{
+			return false;
+		}
+		if (slots[slot] == EmptySlot)
+		{
+			slots[slot] = starID;
+			count++;
+			return true;
+		}
+	}
+}
+
+bool VisitedStarSet::contains(uint32_t starID) const
+{
+	if (starID == EmptySlot)
+	{
+		return containsEmptySlotID;
+	}
+	if (slots.empty())
+	{
+		return false;
+	}
+
+	size_t mask = slots.size() - 1;
+	for (size_t slot = slotFor(starID);; slot = (slot + 1) & mask)
+	{
+		if (slots[slot] == starID)
+		{
+			return true;
+		}
+		if (slots[slot] == EmptySlot)
+		{
+			return false;
+		}
+	}
+}
+
+size_t VisitedStarSet::size() const
+{
+	return count + (containsEmptySlotID ? 1 : 0);
+}
+
+void VisitedStarSet::clear()
+{
+	slots.clear();
+	count = 0;
+	containsEmptySlotID = false;
+}
+
+size_t VisitedStarSet::slotFor(uint32_t starID) const
+{
+	// Fibonacci hashing spreads the mostly sequential catalog IDs across the table.
+	return (static_cast<uint64_t>(starID) * 0x9E3779B97F4A7C15ull >> 32) & (slots.size() - 1);
+}
+
+void VisitedStarSet::grow()
+{
+	std::vector<uint32_t> oldSlots;
+	oldSlots.swap(slots);
+	slots.assign(oldSlots.empty() ? 16 : oldSlots.size() * 2, EmptySlot);
+	count = 0;
+
+	for (uint32_t starID : oldSlots)
+	{
+		if (starID != EmptySlot)
+		{
+			insert(starID);
+		}
+	}
+}
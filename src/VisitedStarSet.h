@@ -0,0 +1,30 @@
+// VisitedStarSet.h
+#ifndef VISITEDSTARSET_H
+#define VISITEDSTARSET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compact open-addressing hash set of star IDs, giving a probe constant time "have I been here?" checks.
+// The ordered trail lives alongside it in Probe::visitedStarSystems for the renderer and summary.
+class VisitedStarSet
+{
+public:
+	VisitedStarSet();
+	bool insert(uint32_t starID); // returns false if the star was already in the set
+	bool contains(uint32_t starID) const;
+	size_t size() const;
+	void clear();
+
+private:
+	static constexpr uint32_t EmptySlot = 0xFFFFFFFFu; // marks an unused slot, so that ID is tracked separately
+	size_t slotFor(uint32_t starID) const;				 // first slot to probe for starID
+	void grow();
+
+	std::vector<uint32_t> slots; // power of two sized, linear probing, kept at most half full
+	size_t count;
+	bool containsEmptySlotID;
+};
+
+#endif // VISITEDSTARSET_H
@@ -0,0 +1,353 @@
+// SpatialIndexTest.cpp
+// Builds every spatial index backend over the same random catalog and checks each query against brute force over
+// the star table, then times them. Any mismatch is printed and fails the run. Optional arguments: star count, query
+// count, random seed.
+#include "GalaxyQuadTree.h"
+#include "SpatialIndex.h"
+#include "Star.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const sf::FloatRect MapBoundary(0.0f, 0.0f, 2800.0f, 1000.0f);
+	const float Infinity = std::numeric_limits<float>::infinity();
+
+	// A map whose quadtree children, after rounding, end at 2772993 while the map itself ends at 2772993.25, so stars
+	// on that last column and row are in the map but outside every child.
+	const sf::FloatRect RoundedMapBoundary(-4485.328125f, -4485.328125f, 2777478.5f, 2777478.5f);
+	const int RoundedChildEdge = 2772993;
+
+	// Stars spread over area and a little beyond it (those are not indexed), with dense clusters and plenty of
+	// stars on the same spot, as zoomed-out catalogs have.
+	std::vector<Star> makeCatalog(const sf::FloatRect &area, size_t starCount, std::mt19937 &random)
+	{
+		std::uniform_real_distribution<float> anyX(area.left - 50.0f, area.left + area.width + 50.0f);
+		std::uniform_real_distribution<float> anyY(area.top - 50.0f, area.top + area.height + 50.0f);
+		std::normal_distribution<float> spread(0.0f, 12.0f);
+		std::vector<Star> stars;
+		stars.reserve(starCount);
+		sf::Vector2f clusterCentre;
+		for (uint32_t id = 0; id < starCount; ++id)
+		{
+			float x, y;
+			if (id % 4 == 0)
+			{
+				clusterCentre = sf::Vector2f(anyX(random), anyY(random));
+			}
+			if (id % 2 == 0)
+			{
+				x = anyX(random);
+				y = anyY(random);
+			}
+			else
+			{
+				x = clusterCentre.x + spread(random);
+				y = clusterCentre.y + spread(random);
+			}
+			stars.emplace_back(id, static_cast<int>(std::floor(x)), static_cast<int>(std::floor(y)), "", sf::Color::White);
+		}
+		return stars;
+	}
+
+	float distanceSquared(const Star &star, const sf::Vector2f &point)
+	{
+		float dx = star.getX() - point.x;
+		float dy = star.getY() - point.y;
+		return dx * dx + dy * dy;
+	}
+
+	struct Query
+	{
+		sf::Vector2f point;
+		float maxDistance;
+		float radius;
+		sf::FloatRect rect; // sometimes with a negative size
+	};
+
+	class BackendCheck
+	{
+	public:
+		BackendCheck(const std::string &type, const sf::FloatRect &boundary, const std::vector<Star> &catalog, ThreadPool &threadPool) : type(type),
+																																		 boundary(boundary),
+																																		 stars(catalog),
+																																		 failures(0)
+		{
+			index = SpatialIndex::create(type, boundary, 32, 16, stars);
+			auto start = std::chrono::steady_clock::now();
+			index->build(threadPool);
+			buildSeconds = secondsSince(start);
+
+			// The same stars, by ID, are explored or claimed in every backend.
+			for (uint32_t starIndex = 0; starIndex < stars.size(); ++starIndex)
+			{
+				if (stars[starIndex].getID() % 5 == 0)
+				{
+					index->markStarExplored(starIndex);
+				}
+				else if (stars[starIndex].getID() % 11 == 0)
+				{
+					index->claimStar(starIndex);
+				}
+			}
+		}
+
+		int run(const std::vector<Query> &queries)
+		{
+			SpatialIndex::StarFilter filter = [this](uint32_t starIndex)
+			{ return stars[starIndex].getID() % 7 != 0; };
+			std::vector<uint32_t> results;
+			std::vector<uint32_t> expected;
+			for (const Query &query : queries)
+			{
+				uint32_t hint = index->locate(query.point + sf::Vector2f(20.0f, -15.0f)); // a nearby earlier position
+				checkNearest("findNearest", query, index->findNearest(query.point, filter, query.maxDistance, hint), false, filter);
+				checkNearest("findNearestAvailable", query, index->findNearestAvailable(query.point, filter, query.maxDistance, hint), true, filter);
+
+				index->findKNearest(query.point, 5, filter, results, query.maxDistance, hint);
+				checkKNearest(query, results, filter);
+
+				index->findInRadius(query.point, query.radius, results);
+				expected.clear();
+				forEachIndexedStar([&](uint32_t starIndex)
+								   { if (distanceSquared(stars[starIndex], query.point) <= query.radius * query.radius) expected.push_back(starIndex); });
+				checkSameStars("findInRadius", query, results, expected);
+
+				index->findInRect(query.rect, results);
+				expected.clear();
+				forEachIndexedStar([&](uint32_t starIndex)
+								   { if (query.rect.contains(static_cast<float>(stars[starIndex].getX()), static_cast<float>(stars[starIndex].getY()))) expected.push_back(starIndex); });
+				checkSameStars("findInRect", query, results, expected);
+			}
+			return failures;
+		}
+
+		void time(const std::vector<Query> &queries)
+		{
+			SpatialIndex::StarFilter filter = [](uint32_t)
+			{ return true; };
+			std::vector<uint32_t> results;
+			size_t found = 0; // keeps the calls from being optimised away
+			double perQuery = 1e6 / static_cast<double>(queries.size());
+
+			auto start = std::chrono::steady_clock::now();
+			for (const Query &query : queries)
+			{
+				found += index->findNearest(query.point, filter) != SpatialIndex::InvalidIndex;
+			}
+			double nearest = secondsSince(start) * perQuery;
+			start = std::chrono::steady_clock::now();
+			for (const Query &query : queries)
+			{
+				found += index->findNearestAvailable(query.point, filter) != SpatialIndex::InvalidIndex;
+			}
+			double nearestAvailable = secondsSince(start) * perQuery;
+			start = std::chrono::steady_clock::now();
+			for (const Query &query : queries)
+			{
+				index->findInRadius(query.point, query.radius, results);
+				found += results.size();
+			}
+			double radius = secondsSince(start) * perQuery;
+			start = std::chrono::steady_clock::now();
+			for (const Query &query : queries)
+			{
+				index->findInRect(query.rect, results);
+				found += results.size();
+			}
+			double rect = secondsSince(start) * perQuery;
+
+			std::cout << "  " << type << ": build " << buildSeconds * 1e3 << " ms, per query (us): findNearest " << nearest
+					  << ", findNearestAvailable " << nearestAvailable << ", findInRadius " << radius << ", findInRect " << rect
+					  << " (" << found << " found)" << std::endl;
+		}
+
+		// Stars the quadtree holds in a node but in none of its children.
+		uint32_t countLeftOverStars() const
+		{
+			const GalaxyQuadTree *quadTree = dynamic_cast<const GalaxyQuadTree *>(index.get());
+			uint32_t leftOver = 0;
+			for (const GalaxyQuadTreeNode &node : quadTree ? quadTree->getNodes() : std::vector<GalaxyQuadTreeNode>())
+			{
+				if (!node.isLeaf())
+				{
+					leftOver += node.starCount;
+					for (int i = 0; i < 4; ++i)
+					{
+						leftOver -= quadTree->getNodes()[node.getChild(i)].starCount;
+					}
+				}
+			}
+			return leftOver;
+		}
+
+	private:
+		static double secondsSince(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		void forEachIndexedStar(const std::function<void(uint32_t)> &visit) const
+		{
+			for (uint32_t starIndex = 0; starIndex < stars.size(); ++starIndex)
+			{
+				if (boundary.contains(static_cast<float>(stars[starIndex].getX()), static_cast<float>(stars[starIndex].getY())))
+				{
+					visit(starIndex);
+				}
+			}
+		}
+
+		// Distances of every star a nearest search may return, nearest first.
+		std::vector<float> candidateDistances(const Query &query, bool availableOnly, const SpatialIndex::StarFilter &filter) const
+		{
+			std::vector<float> distances;
+			forEachIndexedStar([&](uint32_t starIndex)
+							   {
+				float distance = distanceSquared(stars[starIndex], query.point);
+				if ((!availableOnly || stars[starIndex].getIsAvailable()) && filter(starIndex) && distance <= query.maxDistance * query.maxDistance)
+				{
+					distances.push_back(distance);
+				} });
+			std::sort(distances.begin(), distances.end());
+			return distances;
+		}
+
+		// Ties may go to different stars in different backends, as their tables are ordered differently, so a
+		// result is right if it may be returned and is as near as the nearest.
+		void checkNearest(const char *name, const Query &query, uint32_t starIndex, bool availableOnly, const SpatialIndex::StarFilter &filter)
+		{
+			std::vector<float> distances = candidateDistances(query, availableOnly, filter);
+			bool passed = distances.empty() ? starIndex == SpatialIndex::InvalidIndex
+											: starIndex != SpatialIndex::InvalidIndex && filter(starIndex) && (!availableOnly || stars[starIndex].getIsAvailable()) &&
+												  distanceSquared(stars[starIndex], query.point) == distances.front();
+			if (!passed)
+			{
+				fail(name, query, "returned star " + std::to_string(starIndex) + ", expected distance squared " + (distances.empty() ? std::string("none") : std::to_string(distances.front())));
+			}
+		}
+
+		void checkKNearest(const Query &query, const std::vector<uint32_t> &results, const SpatialIndex::StarFilter &filter)
+		{
+			std::vector<float> distances = candidateDistances(query, false, filter);
+			distances.resize(std::min<size_t>(distances.size(), 5));
+			std::vector<float> resultDistances;
+			bool passed = true;
+			for (uint32_t starIndex : results)
+			{
+				passed = passed && filter(starIndex);
+				resultDistances.push_back(distanceSquared(stars[starIndex], query.point));
+			}
+			if (!passed || resultDistances != distances) // nearest first, so the lists match element by element
+			{
+				fail("findKNearest", query, std::to_string(results.size()) + " results, expected " + std::to_string(distances.size()));
+			}
+		}
+
+		void checkSameStars(const char *name, const Query &query, std::vector<uint32_t> results, std::vector<uint32_t> &expected)
+		{
+			std::sort(results.begin(), results.end());
+			std::sort(expected.begin(), expected.end());
+			if (results != expected)
+			{
+				fail(name, query, std::to_string(results.size()) + " stars, expected " + std::to_string(expected.size()));
+			}
+		}
+
+		void fail(const char *name, const Query &query, const std::string &detail)
+		{
+			if (++failures <= 10)
+			{
+				std::cout << "  " << type << " " << name << " at (" << query.point.x << ", " << query.point.y << "): " << detail << std::endl;
+			}
+		}
+
+		std::string type;
+		sf::FloatRect boundary;
+		std::vector<Star> stars; // this backend's copy of the catalog, which it reorders
+		std::unique_ptr<SpatialIndex> index;
+		double buildSeconds;
+		int failures;
+	};
+
+	// Query points mostly over area, some off it. Range and distance limits vary from nothing to a good part of the map.
+	std::vector<Query> makeQueries(const sf::FloatRect &area, size_t queryCount, std::mt19937 &random)
+	{
+		std::uniform_real_distribution<float> anyX(area.left - 200.0f, area.left + area.width + 200.0f);
+		std::uniform_real_distribution<float> anyY(area.top - 200.0f, area.top + area.height + 200.0f);
+		std::uniform_real_distribution<float> size(-150.0f, 300.0f);
+		std::exponential_distribution<float> distance(1.0f / 60.0f);
+		std::vector<Query> queries(queryCount);
+		for (size_t i = 0; i < queryCount; ++i)
+		{
+			Query &query = queries[i];
+			query.point = sf::Vector2f(anyX(random), anyY(random));
+			query.maxDistance = i % 2 == 0 ? Infinity : distance(random);
+			query.radius = distance(random);
+			query.rect = sf::FloatRect(query.point.x, query.point.y, size(random), size(random));
+			if (i % 3 == 0)
+			{
+				// Whole numbers throughout, so stars fall exactly on the edges of the ranges
+				query.point = sf::Vector2f(std::floor(query.point.x), std::floor(query.point.y));
+				query.maxDistance = std::round(query.maxDistance);
+				query.radius = std::round(query.radius);
+				query.rect = sf::FloatRect(query.point.x, query.point.y, std::round(query.rect.width), std::round(query.rect.height));
+			}
+		}
+		return queries;
+	}
+
+	int checkBackends(const sf::FloatRect &boundary, const std::vector<Star> &catalog, const std::vector<Query> &queries, ThreadPool &threadPool,
+					  bool needLeftOverStars)
+	{
+		int failures = 0;
+		std::cout << catalog.size() << " stars, " << queries.size() << " queries" << std::endl;
+		for (const char *type : {"quadtree", "grid", "kdtree"})
+		{
+			BackendCheck check(type, boundary, catalog, threadPool);
+			int backendFailures = check.run(queries);
+			if (needLeftOverStars && type == std::string("quadtree") && check.countLeftOverStars() == 0)
+			{
+				std::cout << "  quadtree: no stars left outside every child, so they are not being checked" << std::endl;
+				++backendFailures;
+			}
+			std::cout << "  " << type << ": " << (backendFailures == 0 ? "matches brute force" : std::to_string(backendFailures) + " mismatches") << std::endl;
+			check.time(queries);
+			failures += backendFailures;
+		}
+		return failures;
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	size_t starCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20000;
+	size_t queryCount = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500;
+	unsigned int seed = argc > 3 ? static_cast<unsigned int>(std::strtoul(argv[3], nullptr, 10)) : 1234;
+	std::mt19937 random(seed);
+	ThreadPool threadPool(0);
+
+	std::vector<Star> catalog = makeCatalog(MapBoundary, starCount, random);
+	int failures = checkBackends(MapBoundary, catalog, makeQueries(MapBoundary, queryCount, random), threadPool, false);
+
+	// Stars crowded around the far corner of RoundedMapBoundary, many of them on its last column and row.
+	sf::FloatRect corner(RoundedChildEdge - 1000.0f, RoundedChildEdge - 1000.0f, 1000.0f, 1000.0f);
+	catalog = makeCatalog(corner, starCount, random);
+	for (uint32_t id = 0; id < starCount / 10; ++id)
+	{
+		int along = RoundedChildEdge - static_cast<int>(random() % 1000);
+		catalog.emplace_back(static_cast<uint32_t>(starCount) + id, id % 2 == 0 ? RoundedChildEdge : along, id % 2 == 0 ? along : RoundedChildEdge, "", sf::Color::White);
+	}
+	failures += checkBackends(RoundedMapBoundary, catalog, makeQueries(corner, queryCount, random), threadPool, true);
+	return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}